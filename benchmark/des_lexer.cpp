@@ -0,0 +1,81 @@
+// Benchmark: des_lexer
+// Report the throughput (MB/s) of the des lexer alone and of the full
+// statement parser on a synthetic in-memory module.
+//
+// Usage: bench_des_lexer [#instances] [#rounds]
+
+#include <sda/headerdef.hpp>
+#include <sda/des/des.hpp>
+
+// Function: generate
+// Build a single module holding a chain of n cells.
+std::string generate(size_t n) {
+
+  std::ostringstream oss;
+
+  oss << "module Bench(in, out);\n"
+      << "input in;\n"
+      << "output out;\n";
+
+  for(size_t i=0; i+1<n; ++i) {
+    oss << "wire w" << i << " dependency;\n";
+  }
+
+  for(size_t i=0; i<n; ++i) {
+    oss << "PR c" << i << "(.i(" << (i == 0 ? "in" : "w" + std::to_string(i-1)) << "), "
+        << ".o(" << (i+1 == n ? "out" : "w" + std::to_string(i)) << "));\n";
+  }
+
+  oss << "endmodule\n";
+
+  return oss.str();
+}
+
+// Function: throughput
+// Return the rate in MB/s of processing the given number of bytes.
+template <typename F>
+double throughput(size_t bytes, size_t rounds, F&& f) {
+  auto beg = std::chrono::steady_clock::now();
+  for(size_t r=0; r<rounds; ++r) {
+    f();
+  }
+  auto end = std::chrono::steady_clock::now();
+  std::chrono::duration<double> sec = end - beg;
+  return bytes * rounds / sec.count() / (1 << 20);
+}
+
+int main(int argc, char* argv[]) {
+
+  size_t n      = argc > 1 ? std::stoul(argv[1]) : 200000;
+  size_t rounds = argc > 2 ? std::stoul(argv[2]) : 5;
+
+  const auto buffer = generate(n);
+
+  std::cout << "buffer: " << buffer.size() / (1 << 20) << " MB, "
+            << n << " instances, " << rounds << " rounds\n";
+
+  size_t num_tokens {0};
+
+  auto lex = throughput(buffer.size(), rounds, [&] () {
+    sda::des::Lexer lexer(buffer);
+    num_tokens = 0;
+    while(not lexer.next().is(sda::des::Token::Type::END)) {
+      ++num_tokens;
+    }
+  });
+
+  std::cout << "lexer : " << std::fixed << std::setprecision(1) << lex << " MB/s ("
+            << num_tokens << " tokens)\n";
+
+  auto parse = throughput(buffer.size(), rounds, [&] () {
+    sda::Des des;
+    if(not des.parse_buffer(buffer)) {
+      std::cerr << "parse failed\n";
+      std::exit(EXIT_FAILURE);
+    }
+  });
+
+  std::cout << "parser: " << std::fixed << std::setprecision(1) << parse << " MB/s\n";
+
+  return 0;
+}
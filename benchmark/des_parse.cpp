@@ -0,0 +1,93 @@
+// Benchmark: des_parse
+// Compare the parse time and the peak RSS of the copy-in path (read the whole
+// file into a std::string) against the memory-mapped path of Des::parse_module.
+// Each path runs in its own child process so the peak RSS is measured in
+// isolation.
+//
+// Usage: bench_des_parse [#instances] [path of the generated file]
+
+#include <sda/headerdef.hpp>
+#include <sda/des/des.hpp>
+#include <sys/resource.h>
+#include <sys/wait.h>
+
+// Procedure: generate
+// Write a single module holding a chain of n cells.
+void generate(const std::filesystem::path& path, size_t n) {
+
+  std::ofstream ofs(path);
+
+  ofs << "module Bench(in, out);\n"
+      << "input in;\n"
+      << "output out;\n";
+
+  for(size_t i=0; i+1<n; ++i) {
+    ofs << "wire w" << i << " dependency;\n";
+  }
+
+  for(size_t i=0; i<n; ++i) {
+    ofs << "PR c" << i << "(.i(" << (i == 0 ? "in" : "w" + std::to_string(i-1)) << "), "
+        << ".o(" << (i+1 == n ? "out" : "w" + std::to_string(i)) << "));\n";
+  }
+
+  ofs << "endmodule\n";
+}
+
+// Procedure: measure
+// Run the parser in a child process and report its elapsed time and peak RSS.
+template <typename F>
+void measure(const char* name, F&& parse) {
+
+  std::cout << std::flush;
+
+  if(pid_t pid = ::fork(); pid == 0) {
+    auto beg = std::chrono::steady_clock::now();
+    bool ok = parse();
+    auto end = std::chrono::steady_clock::now();
+    std::cout << std::setw(10) << name << ": " << (ok ? "ok" : "FAILED") << ", "
+              << std::chrono::duration_cast<std::chrono::milliseconds>(end-beg).count()
+              << " ms";
+    std::cout << std::flush;
+    ::_exit(ok ? EXIT_SUCCESS : EXIT_FAILURE);
+  }
+  else {
+    int status;
+    struct rusage usage;
+    ::wait4(pid, &status, 0, &usage);
+    std::cout << ", peak RSS " << usage.ru_maxrss / 1024 << " MB\n";
+  }
+}
+
+int main(int argc, char* argv[]) {
+
+  size_t n = argc > 1 ? std::stoul(argv[1]) : 200000;
+
+  std::filesystem::path path = argc > 2 ?
+    std::filesystem::path(argv[2]) : std::filesystem::temp_directory_path() / "bench.des";
+
+  generate(path, n);
+
+  std::cout << path << ": " << std::filesystem::file_size(path) / (1 << 20) << " MB, "
+            << n << " instances\n";
+
+  // Legacy path: copy the entire file into a string.
+  measure("copy-in", [&] () {
+    std::ifstream ifs(path);
+    ifs.seekg(0, std::ios::end);
+    std::string buffer(ifs.tellg(), ' ');
+    ifs.seekg(0);
+    ifs.read(&buffer[0], buffer.size());
+    sda::Des des;
+    return des.parse_buffer(buffer);
+  });
+
+  // Memory-mapped path.
+  measure("mmap", [&] () {
+    sda::Des des;
+    return des.parse_module(path);
+  });
+
+  std::filesystem::remove(path);
+
+  return 0;
+}
@@ -0,0 +1,216 @@
+// Benchmark: executor
+// Measure the task launch rate of sda::Executor on a flow of no-op cells and
+// compare it with launching the same binary back to back with posix_spawn,
+// which bounds what any executor can reach on one worker. The flow is a grid
+// of independent chains, so there is always work for every worker.
+//
+// The flow then runs twice with an sda::ActionCache, its cells being this
+// binary: launched with SDA_CELL set, it writes its instance name and its
+// inputs to its outputs. The first run stores every cell, the second must
+// restore every cell without launching a tool, and the restored artifacts
+// and logs must match those written by the tools byte for byte.
+//
+// Usage: bench_executor [#cells] [#workers] [no-op binary] [work dir]
+
+#include <sda/headerdef.hpp>
+#include <sda/des/des.hpp>
+#include <sda/exec/executor.hpp>
+#include <spawn.h>
+#include <sys/wait.h>
+
+// Function: generate
+// A module of n cells in chains of the given length, linked by dependency
+// wires.
+std::string generate(size_t n, size_t length) {
+
+  std::ostringstream oss;
+
+  oss << "module Bench();\n";
+
+  for(size_t i=0; i<n; ++i) {
+    if((i+1) % length != 0 && i+1 < n) {
+      oss << "wire w" << i << " dependency;\n";
+    }
+  }
+
+  for(size_t i=0; i<n; ++i) {
+    oss << "NOP c" << i << "(";
+    if(i % length != 0) {
+      oss << ".i(w" << i-1 << ")";
+    }
+    if((i+1) % length != 0 && i+1 < n) {
+      oss << (i % length != 0 ? ", " : "") << ".o(w" << i << ")";
+    }
+    oss << ");\n";
+  }
+
+  oss << "endmodule\n";
+
+  return oss.str();
+}
+
+// Function: cell
+// Run as a cell of the cached flow.
+int cell() {
+
+  std::string content {std::getenv("SDA_INSTANCE")};
+  content.push_back('\n');
+
+  std::istringstream inputs {std::getenv("SDA_INPUTS")};
+  for(std::string path; std::getline(inputs, path, ':'); ) {
+    std::ifstream ifs(path, std::ios::binary);
+    if(!ifs) {
+      return EXIT_FAILURE;
+    }
+    content.append(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+  }
+
+  std::istringstream outputs {std::getenv("SDA_OUTPUTS")};
+  for(std::string path; std::getline(outputs, path, ':'); ) {
+    if(!(std::ofstream(path, std::ios::binary) << content)) {
+      return EXIT_FAILURE;
+    }
+  }
+
+  std::cout << content;
+
+  return EXIT_SUCCESS;
+}
+
+// Function: snapshot
+// Read every regular file under a directory.
+std::map<std::string, std::string> snapshot(const std::filesystem::path& dir) {
+  std::map<std::string, std::string> files;
+  for(const auto& entry : std::filesystem::recursive_directory_iterator(dir)) {
+    if(std::filesystem::is_regular_file(entry.status())) {
+      std::ifstream ifs(entry.path(), std::ios::binary);
+      files[entry.path().string()].assign(std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>());
+    }
+  }
+  return files;
+}
+
+// Function: spawn_rate
+// Launch the binary n times in a row and return the launches per second.
+double spawn_rate(const std::string& binary, size_t n) {
+
+  char* argv[] = {const_cast<char*>(binary.c_str()), nullptr};
+
+  auto beg = std::chrono::steady_clock::now();
+  for(size_t i=0; i<n; ++i) {
+    pid_t pid;
+    int status;
+    if(::posix_spawn(&pid, binary.c_str(), nullptr, nullptr, argv, environ) != 0 ||
+       ::waitpid(pid, &status, 0) == -1) {
+      return 0;
+    }
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  return n / std::chrono::duration<double>(end - beg).count();
+}
+
+int main(int argc, char* argv[]) {
+
+  if(std::getenv("SDA_CELL") != nullptr) {
+    return cell();
+  }
+
+  size_t n         = argc > 1 ? std::stoul(argv[1]) : 20000;
+  unsigned workers = argc > 2 ? std::stoul(argv[2]) : std::thread::hardware_concurrency();
+
+  const std::string binary = argc > 3 ? argv[3] : "/bin/true";
+  const std::filesystem::path work_dir = argc > 4 ? argv[4] : "bench_executor.work";
+  const std::filesystem::path cache_dir = work_dir.string() + ".cache";
+
+  const auto self {std::filesystem::read_symlink("/proc/self/exe").string()};
+
+  sda::Des des;
+  sda::TechLibrary tech, writer;
+
+  auto nop = [] (const std::string& binary) {
+    return "cell:\n  - name: NOP\n  - binary: " + binary + "\n"
+           "  - pin:\n      name: i\n      direction: in\n"
+           "  - pin:\n      name: o\n      direction: out\n";
+  };
+
+  if(!des.parse_buffer(generate(n, 8)) || !des.build_graph() || !tech.parse(nop(binary)) ||
+     !writer.parse(nop(self))) {
+    return EXIT_FAILURE;
+  }
+
+  const auto graph {des.flatten(sda::intern("Bench")).freeze()};
+
+  std::cout << "flow: " << graph.num_vertices() << " cells, " << graph.num_edges() << " wires, "
+            << workers << " workers, no-op " << binary << '\n';
+
+  const double spawn = spawn_rate(binary, std::min<size_t>(n, 2000));
+
+  auto run = [&] (unsigned w) {
+    sda::Executor executor(graph, tech);
+    executor.num_workers(w).work_dir(work_dir);
+    auto beg = std::chrono::steady_clock::now();
+    if(!executor.run() || executor.num_launched() != n) {
+      return 0.0;
+    }
+    auto end = std::chrono::steady_clock::now();
+    return n / std::chrono::duration<double>(end - beg).count();
+  };
+
+  const double serial = run(1);
+  const double parallel = run(workers);
+
+  std::filesystem::remove_all(work_dir);
+
+  if(serial == 0 || parallel == 0) {
+    std::cerr << "the flow failed\n";
+    return EXIT_FAILURE;
+  }
+
+  // The same flow through the action cache: every cell is stored, then
+  // every cell is restored
+  std::filesystem::remove_all(cache_dir);
+
+  sda::ActionCache cache(cache_dir);
+
+  auto cached_run = [&] (size_t launched, size_t cached) {
+    sda::Executor executor(graph, writer);
+    executor.num_workers(workers).work_dir(work_dir).cache(&cache);
+    auto beg = std::chrono::steady_clock::now();
+    if(!executor.run() || executor.num_launched() != launched || executor.num_cached() != cached) {
+      std::cerr << "cached run: " << executor.num_launched() << " launched, "
+                << executor.num_cached() << " cached, expected " << launched << " and " << cached << '\n';
+      return 0.0;
+    }
+    auto end = std::chrono::steady_clock::now();
+    return n / std::chrono::duration<double>(end - beg).count();
+  };
+
+  const double stored = cached_run(n, 0);
+  const auto written {snapshot(work_dir)};
+  const double restored = stored == 0 ? 0 : cached_run(0, n);
+  const bool identical {snapshot(work_dir) == written};
+
+  std::filesystem::remove_all(work_dir);
+  std::filesystem::remove_all(cache_dir);
+
+  if(stored == 0 || restored == 0) {
+    return EXIT_FAILURE;
+  }
+
+  if(!identical) {
+    std::cerr << "the restored artifacts differ from the ones the tools wrote\n";
+    return EXIT_FAILURE;
+  }
+
+  std::cout << std::fixed << std::setprecision(1)
+            << "posix_spawn: " << spawn << " launches/s\n"
+            << "executor -j1: " << serial << " launches/s, "
+            << (1e6 / serial - 1e6 / spawn) << " us/task overhead\n"
+            << "executor -j" << workers << ": " << parallel << " launches/s\n"
+            << "action cache, store: " << stored << " cells/s\n"
+            << "action cache, restore: " << restored << " cells/s, "
+            << written.size() << " artifacts and logs identical\n";
+
+  return 0;
+}
@@ -0,0 +1,161 @@
+// Benchmark: netlist
+// Read a synthetic flat netlist with sda::des::read_verilog and report the
+// throughput (MB/s) and the peak memory per gate, which should stay below
+// 1 KB. The netlist is streamed to a file rather than built in memory so
+// that the peak memory measured is that of the reader alone. The netlist is
+// then written back with sda::des::write_verilog and, as the baseline, with
+// one iostream insertion per token.
+//
+// Usage: bench_netlist [#gates] [#threads] [file]
+
+#include <sda/headerdef.hpp>
+#include <sda/des/module.hpp>
+#include <sys/resource.h>
+
+// Function: max_rss
+// Return the peak resident set size of the process in bytes.
+size_t max_rss() {
+  struct rusage usage;
+  getrusage(RUSAGE_SELF, &usage);
+  return static_cast<size_t>(usage.ru_maxrss) * 1024;
+}
+
+// Procedure: legacy_write
+// Write the netlist token by token through an std::ofstream.
+void legacy_write(const std::filesystem::path& path, const sda::des::Netlist& n) {
+
+  std::ofstream ofs(path);
+
+  ofs << "module " << n.name << " (";
+  for(size_t i=0; i<n.ports.size(); ++i) {
+    ofs << (i ? ", " : "") << n.ports[i];
+  }
+  ofs << ");\n";
+
+  for(const auto& d : n.declarations) {
+    ofs << (d.direction == sda::des::Netlist::Direction::INPUT ? "input" :
+            d.direction == sda::des::Netlist::Direction::OUTPUT ? "output" :
+            d.direction == sda::des::Netlist::Direction::INOUT ? "inout" : "wire") << ' ';
+    if(d.bus) {
+      ofs << '[' << d.msb << ':' << d.lsb << "] " << n.buses[d.name];
+    }
+    else {
+      ofs << n.nets[d.name];
+    }
+    ofs << ";\n";
+  }
+
+  for(uint32_t g=0; g<n.num_gates(); ++g) {
+    ofs << sda::name_of(n.gate_cells[g]) << ' ' << n.gates[g] << " (";
+    for(auto p=n.pin_offsets[g]; p<n.pin_offsets[g+1]; ++p) {
+      ofs << (p == n.pin_offsets[g] ? " ." : ", .") << sda::name_of(n.pin_names[p]) << '(';
+      if(n.pin_nets[p] != sda::des::Netlist::NONE) {
+        ofs << n.nets[n.pin_nets[p]];
+      }
+      ofs << ')';
+    }
+    ofs << " );\n";
+  }
+
+  ofs << "endmodule\n";
+}
+
+// Function: seconds
+// Return the time in seconds taken by a call.
+template <typename F>
+double seconds(F&& f) {
+  auto beg = std::chrono::steady_clock::now();
+  f();
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(end - beg).count();
+}
+
+// Procedure: generate
+// Write a flat verilog module of n two-input gates, with a bus on the ports.
+void generate(const std::filesystem::path& path, size_t n) {
+
+  std::ofstream ofs(path);
+
+  ofs << "module top (in, out, sel);\ninput in;\noutput out;\ninput [7:0] sel;\n";
+
+  for(size_t i=0; i<n; ++i) {
+    ofs << "wire n" << i << ";\n";
+  }
+
+  for(size_t i=0; i<n; ++i) {
+    ofs << "NAND2_X1 g" << i << " ( .A1(" << (i < 2 ? "in" : "n" + std::to_string(i-2)) << "), "
+        << ".A2(" << (i % 16 == 0 ? "sel[" + std::to_string(i % 8) + "]" : "n" + std::to_string(i-1)) << "), "
+        << ".ZN(" << (i+1 == n ? "out" : "n" + std::to_string(i)) << ") );\n";
+  }
+
+  ofs << "endmodule\n";
+}
+
+int main(int argc, char* argv[]) {
+
+  size_t n         = argc > 1 ? std::stoul(argv[1]) : 10000000;
+  unsigned threads = argc > 2 ? std::stoul(argv[2]) : std::thread::hardware_concurrency();
+
+  const std::filesystem::path path = argc > 3 ? argv[3] : "bench_netlist.v";
+
+  generate(path, n);
+
+  const size_t bytes = std::filesystem::file_size(path);
+
+  std::cout << "netlist: " << bytes / (1 << 20) << " MB, "
+            << n << " gates, " << threads << " threads\n";
+
+  const size_t rss = max_rss();
+
+  std::optional<sda::des::Netlist> netlist;
+
+  const double read = seconds([&] () {
+    netlist = sda::des::read_verilog(path, threads);
+  });
+
+  const size_t peak = max_rss() - rss;
+
+  if(!netlist || netlist->num_gates() != n) {
+    std::cerr << "failed to read " << path << '\n';
+    return EXIT_FAILURE;
+  }
+
+  // Write back over the input file
+  const double legacy = seconds([&] () {
+    legacy_write(path, *netlist);
+  });
+
+  const size_t legacy_bytes = std::filesystem::file_size(path);
+
+  bool written {false};
+
+  const double write = seconds([&] () {
+    written = sda::des::write_verilog(path, *netlist, threads);
+  });
+
+  const size_t written_bytes = std::filesystem::file_size(path);
+
+  if(argc <= 3) {
+    std::filesystem::remove(path);
+  }
+
+  if(!written || written_bytes != legacy_bytes) {
+    std::cerr << "failed to write " << path << '\n';
+    return EXIT_FAILURE;
+  }
+
+  std::cout << std::fixed << std::setprecision(1)
+            << netlist->info() << '\n'
+            << "read  : " << read << " s, " << bytes / read / (1 << 20) << " MB/s\n"
+            << "write : " << write << " s, " << written_bytes / write / (1 << 20) << " MB/s "
+            << "(iostream: " << legacy << " s, " << legacy / write << "x)\n"
+            << "memory: " << static_cast<double>(netlist->memory()) / n << " B/gate (netlist), "
+            << static_cast<double>(peak) / n << " B/gate (peak)\n";
+
+  if(peak >= n * 1024) {
+    std::cerr << "peak memory exceeds 1 KB per gate\n";
+    return EXIT_FAILURE;
+  }
+
+  return 0;
+}
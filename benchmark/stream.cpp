@@ -0,0 +1,215 @@
+// Benchmark: stream
+// Push a stream through a stream wire between two dummy cells run by
+// sda::Executor and report the throughput over a plain pipe and through a
+// splice relay, with the default and 1 MB pipe buffers. The dummy cells are
+// this binary: launched with SDA_CELL set, it writes or reads the number of
+// bytes in BENCH_STREAM_BYTES. The relay alone is then compared, in one
+// process, with the read/write copy loop it replaces.
+//
+// Usage: bench_stream [GB] [work dir]
+
+#include <sda/headerdef.hpp>
+#include <sda/des/des.hpp>
+#include <sda/exec/executor.hpp>
+#include <sda/exec/relay.hpp>
+
+constexpr size_t CHUNK {1 << 20};
+
+// Function: cell
+// Run as the producer (SRC) or the consumer (DST) of the stream wire.
+int cell(const std::string& name) {
+
+  const size_t n = std::stoull(std::getenv("BENCH_STREAM_BYTES"));
+
+  std::string path {std::getenv(name == "SRC" ? "SDA_STREAM_OUTPUTS" : "SDA_STREAM_INPUTS")};
+  path = path.substr(path.find('=') + 1);
+
+  const int fd = ::open(path.c_str(), name == "SRC" ? O_WRONLY : O_RDONLY);
+  if(fd == -1) {
+    return EXIT_FAILURE;
+  }
+
+  std::vector<char> buf(CHUNK, 'x');
+
+  size_t total {0};
+
+  if(name == "SRC") {
+    while(total < n) {
+      auto ret = ::write(fd, buf.data(), std::min(CHUNK, n - total));
+      if(ret <= 0) {
+        return EXIT_FAILURE;
+      }
+      total += ret;
+    }
+  }
+  else {
+    ssize_t ret;
+    while((ret = ::read(fd, buf.data(), CHUNK)) > 0) {
+      total += ret;
+    }
+  }
+
+  return total == n ? EXIT_SUCCESS : EXIT_FAILURE;
+}
+
+// Function: seconds
+// Return the time in seconds taken by a call, or 0 if it fails.
+template <typename F>
+double seconds(F&& f) {
+  auto beg = std::chrono::steady_clock::now();
+  if(!f()) {
+    return 0;
+  }
+  auto end = std::chrono::steady_clock::now();
+  return std::chrono::duration<double>(end - beg).count();
+}
+
+// Function: copy_relay
+// The user-space relay: read from one pipe and write to the other.
+bool copy_relay(int in, int out) {
+  std::vector<char> buf(CHUNK);
+  ssize_t ret;
+  while((ret = ::read(in, buf.data(), CHUNK)) > 0) {
+    for(ssize_t w=0; w<ret; ) {
+      auto k = ::write(out, buf.data() + w, ret - w);
+      if(k <= 0) {
+        return false;
+      }
+      w += k;
+    }
+  }
+  return ret == 0;
+}
+
+// Function: in_process
+// Stream n bytes from a producer thread to a consumer thread through a relay
+// thread and two pipes of the given size. Returns the seconds taken.
+double in_process(size_t n, size_t pipe_size, bool splice, sda::RelayStats& stats) {
+
+  int a[2], b[2];
+  if(::pipe2(a, O_CLOEXEC) != 0 || ::pipe2(b, O_CLOEXEC) != 0) {
+    return 0;
+  }
+  sda::pipe_size(a[0], pipe_size);
+  sda::pipe_size(b[0], pipe_size);
+
+  return seconds([&] () {
+
+    std::thread producer([&] () {
+      std::vector<char> buf(CHUNK, 'x');
+      for(size_t total=0; total<n; ) {
+        auto ret = ::write(a[1], buf.data(), std::min(CHUNK, n - total));
+        if(ret <= 0) {
+          break;
+        }
+        total += ret;
+      }
+      ::close(a[1]);
+    });
+
+    std::thread relay([&] () {
+      splice ? sda::Relay(a[0], b[1]).run(stats) : copy_relay(a[0], b[1]);
+      ::close(a[0]);
+      ::close(b[1]);
+    });
+
+    std::vector<char> buf(CHUNK);
+    size_t total {0};
+    ssize_t ret;
+    while((ret = ::read(b[0], buf.data(), CHUNK)) > 0) {
+      total += ret;
+    }
+    ::close(b[0]);
+
+    producer.join();
+    relay.join();
+
+    return total == n;
+  });
+}
+
+int main(int argc, char* argv[]) {
+
+  if(const char* name = std::getenv("SDA_CELL"); name != nullptr) {
+    return cell(name);
+  }
+
+  const size_t n = static_cast<size_t>((argc > 1 ? std::stod(argv[1]) : 4.0) * (1ull << 30));
+  const std::filesystem::path work_dir = argc > 2 ? argv[2] : "bench_stream.work";
+
+  const auto self {std::filesystem::read_symlink("/proc/self/exe").string()};
+
+  sda::Des des;
+  sda::TechLibrary tech;
+
+  if(!des.parse_buffer(
+       "module Bench();\n"
+       "wire s stream;\n"
+       "SRC src(.o(s));\n"
+       "DST dst(.i(s));\n"
+       "endmodule\n"
+     ) || !des.build_graph() || !tech.parse(
+       "cell:\n  - name: SRC\n  - binary: " + self + "\n"
+       "  - pin:\n      name: o\n      direction: out\n      type: stream\n"
+       "---\n"
+       "cell:\n  - name: DST\n  - binary: " + self + "\n"
+       "  - pin:\n      name: i\n      direction: in\n      type: stream\n"
+     )) {
+    return EXIT_FAILURE;
+  }
+
+  const auto graph {des.flatten(sda::intern("Bench")).freeze()};
+
+  ::setenv("BENCH_STREAM_BYTES", std::to_string(n).c_str(), 1);
+
+  const double gb = static_cast<double>(n) / (1ull << 30);
+
+  std::cout << "stream: " << gb << " GB from src to dst, " << graph.num_edges() << " stream wire\n"
+            << std::fixed << std::setprecision(2);
+
+  auto run = [&] (const std::string& what, size_t pipe_size, bool relay) {
+    sda::Executor executor(graph, tech);
+    executor.work_dir(work_dir).pipe_size(pipe_size).relay(relay);
+    const double s = seconds([&] () { return executor.run(); });
+    if(s == 0) {
+      std::cerr << what << ": the flow failed\n";
+      return false;
+    }
+    std::cout << std::setw(32) << std::left << what << gb / s << " GB/s";
+    if(relay) {
+      const auto& stats {executor.relay_stats(0)};
+      std::cout << " (" << stats.splices << " splices, " << stats.stalls << " stalls, "
+                << stats.stalled_ns / 1e6 << " ms backpressure, " << stats.idle_ns / 1e6 << " ms idle)";
+    }
+    std::cout << '\n';
+    return true;
+  };
+
+  const bool ok = run("pipe, default buffer", 0, false) &&
+                  run("pipe, 1 MB buffer", 1 << 20, false) &&
+                  run("splice relay, default buffers", 0, true) &&
+                  run("splice relay, 1 MB buffers", 1 << 20, true);
+
+  std::filesystem::remove_all(work_dir);
+
+  if(!ok) {
+    return EXIT_FAILURE;
+  }
+
+  // The relay data plane alone
+  sda::RelayStats stats, unused;
+
+  const double spliced = in_process(n, 0, true, stats);
+  const double copied = in_process(n, 0, false, unused);
+
+  if(spliced == 0 || copied == 0) {
+    std::cerr << "the in-process relay failed\n";
+    return EXIT_FAILURE;
+  }
+
+  std::cout << std::setw(32) << std::left << "in-process splice relay" << gb / spliced << " GB/s\n"
+            << std::setw(32) << std::left << "in-process copy relay" << gb / copied << " GB/s ("
+            << copied / spliced << "x the splice relay time)\n";
+
+  return 0;
+}
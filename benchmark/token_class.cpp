@@ -0,0 +1,118 @@
+// Benchmark: token_class
+// Compare the token class matchers against the former std::regex matchers
+// and count the heap allocations made while classifying. The matchers must
+// not allocate at all.
+//
+// Usage: bench_token_class [#tokens] [#rounds]
+
+#include <sda/headerdef.hpp>
+#include <sda/utility/tokenizer.hpp>
+
+// Number of calls to the global operator new
+static std::atomic<size_t> num_allocations {0};
+
+void* operator new (size_t size) {
+  ++num_allocations;
+  if(void* p = std::malloc(size == 0 ? 1 : size)) {
+    return p;
+  }
+  throw std::bad_alloc();
+}
+
+void operator delete (void* p) noexcept {
+  std::free(p);
+}
+
+void operator delete (void* p, size_t) noexcept {
+  std::free(p);
+}
+
+// Function: legacy_class
+// The former matchers, which compile a regex on every call.
+sda::TokenClass legacy_class(const std::string& token) {
+  if(std::regex_match(token, std::regex("[a-zA-Z_][a-zA-Z_0-9]*"))) {
+    return sda::TokenClass::WORD;
+  }
+  if(std::regex_match(token, std::regex("[a-zA-Z_][a-zA-Z_0-9]*(\\[[0-9]+\\])+"))) {
+    return sda::TokenClass::ARRAY;
+  }
+  if(std::regex_match(token, std::regex("(\\+|-)?[0-9]*(\\.?([0-9]+))$"))) {
+    return sda::TokenClass::NUMERIC;
+  }
+  return sda::TokenClass::OTHER;
+}
+
+// Function: generate
+// Build a mix of words, array references, numbers and punctuation.
+std::vector<std::string> generate(size_t n) {
+
+  std::vector<std::string> tokens;
+  tokens.reserve(n);
+
+  for(size_t i=0; i<n; ++i) {
+    switch(i % 5) {
+      case 0: tokens.push_back("net_" + std::to_string(i)); break;
+      case 1: tokens.push_back("bus[" + std::to_string(i % 64) + "][3]"); break;
+      case 2: tokens.push_back(std::to_string(i) + ".25"); break;
+      case 3: tokens.push_back("-" + std::to_string(i)); break;
+      default: tokens.push_back(i % 2 ? "(" : ".ZN"); break;
+    }
+  }
+
+  return tokens;
+}
+
+int main(int argc, char* argv[]) {
+
+  size_t n      = argc > 1 ? std::stoul(argv[1]) : 1000000;
+  size_t rounds = argc > 2 ? std::stoul(argv[2]) : 10;
+
+  const auto tokens = generate(n);
+
+  std::vector<std::string_view> views(tokens.begin(), tokens.end());
+  std::vector<sda::TokenClass> classes(n);
+
+  // The regex matchers are too slow to run on every token
+  const size_t num_legacy = std::min(n, size_t{20000});
+
+  num_allocations = 0;
+  auto beg = std::chrono::steady_clock::now();
+  for(size_t i=0; i<num_legacy; ++i) {
+    classes[i] = legacy_class(tokens[i]);
+  }
+  auto end = std::chrono::steady_clock::now();
+
+  const size_t legacy_allocations = num_allocations;
+  const double legacy_ns = std::chrono::duration<double, std::nano>(end - beg).count() / num_legacy;
+
+  for(size_t i=0; i<num_legacy; ++i) {
+    if(classes[i] != sda::classify_token(tokens[i])) {
+      std::cerr << "class mismatch on token " << tokens[i] << '\n';
+      return EXIT_FAILURE;
+    }
+  }
+
+  num_allocations = 0;
+  beg = std::chrono::steady_clock::now();
+  for(size_t r=0; r<rounds; ++r) {
+    sda::classify_tokens(views.begin(), views.end(), classes.begin());
+  }
+  end = std::chrono::steady_clock::now();
+
+  const size_t allocations = num_allocations;
+  const double ns = std::chrono::duration<double, std::nano>(end - beg).count() / (n * rounds);
+
+  std::cout << std::fixed << std::setprecision(1)
+            << "regex  : " << legacy_ns << " ns/token, "
+            << legacy_allocations << " allocations (" << num_legacy << " tokens)\n"
+            << "matcher: " << ns << " ns/token, "
+            << allocations << " allocations (" << n * rounds << " tokens, "
+            << legacy_ns / ns << "x)\n";
+
+  if(allocations != 0) {
+    std::cerr << "token classification allocated memory\n";
+    return EXIT_FAILURE;
+  }
+
+  return 0;
+}
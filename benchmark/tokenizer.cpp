@@ -0,0 +1,115 @@
+// Benchmark: tokenizer
+// Compare the throughput (MB/s) of sda::tokenize against the former
+// character-by-character tokenizer on a synthetic gate-level netlist.
+//
+// Usage: bench_tokenizer [#gates] [#rounds]
+
+#include <sda/headerdef.hpp>
+#include <sda/utility/tokenizer.hpp>
+
+// Function: legacy_tokenize
+// The tokenizer replaced by sda::Tokenizer, kept verbatim as the baseline.
+std::vector<std::string> legacy_tokenize(const std::string& str, std::string_view dels, std::string_view exps) {
+
+  // Parse the token.
+  std::string token;
+  std::vector<std::string> tokens;
+
+  for(size_t i=0; i<str.size(); ++i) {
+    bool is_del = (dels.find(str[i]) != std::string_view::npos);
+    if(is_del || str[i] == ' ' || str[i] == '\n' || str[i] == '\r') {
+      if(!token.empty()) {                            // Add the current token.
+        tokens.push_back(std::move(token));
+        token.clear();
+      }
+      if(is_del && exps.find(str[i]) != std::string_view::npos) {
+        token.push_back(str[i]);
+        tokens.push_back(std::move(token));
+      }
+    } else {
+      token.push_back(str[i]);  // Add the char to the current token.
+    }
+  }
+
+  if(!token.empty()) {
+    tokens.push_back(std::move(token));
+  }
+
+  return tokens;
+}
+
+// Function: generate
+// Build a flat verilog module of n two-input gates.
+std::string generate(size_t n) {
+
+  std::ostringstream oss;
+
+  oss << "module top (in, out);\ninput in;\noutput out;\n";
+
+  for(size_t i=0; i<n; ++i) {
+    oss << "wire n" << i << ";\n";
+  }
+
+  for(size_t i=0; i<n; ++i) {
+    oss << "NAND2_X1 g" << i << " ( .A1(" << (i < 2 ? "in" : "n" + std::to_string(i-2)) << "), "
+        << ".A2(" << (i < 1 ? "in" : "n" + std::to_string(i-1)) << "), "
+        << ".ZN(" << (i+1 == n ? "out" : "n" + std::to_string(i)) << ") );\n";
+  }
+
+  oss << "endmodule\n";
+
+  return oss.str();
+}
+
+// Function: throughput
+// Return the rate in MB/s of processing the given number of bytes.
+template <typename F>
+double throughput(size_t bytes, size_t rounds, F&& f) {
+  auto beg = std::chrono::steady_clock::now();
+  for(size_t r=0; r<rounds; ++r) {
+    f();
+  }
+  auto end = std::chrono::steady_clock::now();
+  std::chrono::duration<double> sec = end - beg;
+  return bytes * rounds / sec.count() / (1 << 20);
+}
+
+int main(int argc, char* argv[]) {
+
+  size_t n      = argc > 1 ? std::stoul(argv[1]) : 500000;
+  size_t rounds = argc > 2 ? std::stoul(argv[2]) : 5;
+
+  static std::string_view delimiters = "(),:;/#[]{}*\"\\";
+  static std::string_view exceptions = "().";
+
+  const auto buffer = generate(n);
+
+  std::cout << "buffer: " << buffer.size() / (1 << 20) << " MB, "
+            << n << " gates, " << rounds << " rounds\n";
+
+  size_t num_legacy {0}, num_tokens {0};
+
+  auto legacy = throughput(buffer.size(), rounds, [&] () {
+    num_legacy = legacy_tokenize(buffer, delimiters, exceptions).size();
+  });
+
+  const sda::Tokenizer tokenizer(delimiters, exceptions);
+  std::vector<std::string_view> tokens;
+
+  auto table = throughput(buffer.size(), rounds, [&] () {
+    tokens.clear();
+    tokenizer.tokenize(buffer, tokens);
+    num_tokens = tokens.size();
+  });
+
+  if(num_legacy != num_tokens) {
+    std::cerr << "token count mismatch: " << num_legacy << " vs " << num_tokens << '\n';
+    return EXIT_FAILURE;
+  }
+
+  std::cout << std::fixed << std::setprecision(1)
+            << "legacy   : " << legacy << " MB/s (" << num_legacy << " tokens)\n"
+            << "tokenizer: " << table << " MB/s (" << table / legacy << "x)\n";
+
+  return 0;
+}
@@ -1,19 +1,92 @@
 #include <sda/headerdef.hpp>
 #include <sda/des/des.hpp>
+#include <sda/exec/executor.hpp>
+#include <sda/utility/CLI11.hpp>
 #include <cassert>
 
-int main(){
+int main(int argc, char* argv[]){
+
+  CLI::App app {"SoftDA: software-defined flows of design automation tools"};
+
+  std::vector<std::string> flow_files {
+    "/home/clin99/SoftDA/example/darpa-idea/flow.des",
+    "/home/clin99/SoftDA/example/darpa-idea/signoff.des"
+  };
+  std::string cache;
+  std::string tech;
+  std::string top;
+  std::string work_dir {"."};
+  unsigned jobs {std::thread::hardware_concurrency()};
+  bool fifos {false};
+  bool relay {false};
+  bool tap {false};
+  size_t pipe_size {0};
+  std::string action_cache;
+
+  app.add_option("flows", flow_files, "des files of the flow");
+  app.add_option("-c,--cache", cache, "binary cache of the parsed flow, none by default");
+  app.add_option("-t,--tech", tech, "tech file or directory of tech files");
+  app.add_option("-r,--run", top, "run the flow of this module");
+  app.add_option("-w,--work-dir", work_dir, "work directory of the tools");
+  app.add_option("-j,--jobs", jobs, "number of tools to run at once");
+  app.add_flag("--fifos", fifos, "pass stream wires to the tools as named pipes");
+  app.add_flag("--relay", relay, "relay stream wires and report their traffic");
+  app.add_flag("--tap", tap, "relay stream wires and copy them to the work directory");
+  app.add_option("--pipe-size", pipe_size, "buffer size of stream pipes in bytes, 0 for the system default");
+  app.add_option("--action-cache", action_cache, "directory of the cache of tool outputs");
+
+  CLI11_PARSE(app, argc, argv);
+
+  const std::vector<std::filesystem::path> flows(flow_files.begin(), flow_files.end());
+
+  // Parse and build only if there is no cache or it is missing or stale
   sda::Des parser;
-  assert(parser.parse_module("/home/clin99/SoftDA/example/darpa-idea/flow.des"));
-  assert(parser.parse_module("/home/clin99/SoftDA/example/darpa-idea/signoff.des"));
-
-  const auto& modules = parser.get_all_modules();
-  for(const auto& iter : modules){
-    std::cout << "Detail " << iter.first << "\n";
-    auto str = parser.dump_module(iter.first);
-    std::cout << str << "\n";
+  if(not tech.empty() and not parser.load_tech(tech, jobs)){
+    return EXIT_FAILURE;
+  }
+  if(cache.empty() or not parser.load_cache(cache, flows)){
+    if(not parser.parse_modules(flows) or not parser.build_graph(jobs)){
+      return EXIT_FAILURE;
+    }
+    if(not cache.empty() and not parser.save_cache(cache)){
+      std::cerr << "failed to write the cache " << cache << '\n';
+    }
   }
 
+  if(not top.empty()){
+    const auto& graphs = parser.get_all_graphs();
+    if(not sda::SymbolTable::get().contains(top) or graphs.find(sda::intern(top)) == graphs.end()){
+      std::cerr << "no module " << top << '\n';
+      return EXIT_FAILURE;
+    }
+    const auto graph {parser.flatten(sda::intern(top)).freeze()};
+    std::optional<sda::ActionCache> actions;
+    if(not action_cache.empty()){
+      actions.emplace(action_cache);
+    }
+    sda::Executor executor(graph, parser.get_tech());
+    executor.num_workers(jobs).work_dir(work_dir).fifos(fifos).pipe_size(pipe_size).relay(relay).tap(tap)
+            .cache(actions ? &*actions : nullptr);
+    const bool ok {executor.run()};
+    if(actions){
+      std::cout << executor.num_cached() << " of " << graph.num_vertices() << " cells restored from "
+                << actions->dir().string() << '\n';
+    }
+    if(relay or tap){
+      for(uint32_t e=0; e<graph.num_edges(); ++e){
+        if(const auto& s {executor.relay_stats(e)}; s.elapsed_ns != 0){
+          std::cout << sda::render(graph.edge_names[e]) << ": " << s.bytes << " bytes, "
+                    << s.throughput() / (1 << 20) << " MB/s, " << s.stalls << " stalls, "
+                    << s.stalled_ns / 1000000 << " ms backpressure, " << s.idle_ns / 1000000 << " ms idle\n";
+        }
+      }
+    }
+    return ok ? EXIT_SUCCESS : EXIT_FAILURE;
+  }
+
+  // Modules in name order
+  parser.dump_all(std::cout);
+
   //parser._keyword_module("abcd");
   //parser._keyword_module("modu");
   //parser._keyword_module("module");
@@ -0,0 +1,150 @@
+#ifndef SDA_DES_CSR_HPP_
+#define SDA_DES_CSR_HPP_
+
+#include <cstdint>
+#include <limits>
+#include <utility>
+#include <vector>
+#include <sda/utility/path.hpp>
+
+namespace sda::des {
+
+// Struct: CsrGraph
+// Frozen, compressed-sparse-row view of a flattened graph. Vertices and edges
+// are numbered densely and stored in contiguous arrays. The outgoing edges of
+// vertex v are fanout[fanout_offsets[v] .. fanout_offsets[v+1]) and the
+// incoming ones are laid out the same way in fanin. An edge endpoint that is
+// not a vertex is NONE.
+struct CsrGraph {
+
+  static constexpr uint32_t NONE {std::numeric_limits<uint32_t>::max()};
+
+  // Struct: Span
+  struct Span {
+    const uint32_t* first {nullptr};
+    const uint32_t* last {nullptr};
+    const uint32_t* begin() const { return first; }
+    const uint32_t* end() const { return last; }
+    size_t size() const { return last - first; }
+    bool empty() const { return first == last; }
+  };
+
+  // vertex id -> instance path, cell name
+  std::vector<Path> vertex_names;
+  std::vector<Symbol> vertex_cells;
+
+  // edge id -> wire path, source vertex, target vertex, stream or dependency
+  std::vector<Path> edge_names;
+  std::vector<uint32_t> edge_from;
+  std::vector<uint32_t> edge_to;
+  std::vector<bool> edge_stream;
+
+  std::vector<uint32_t> fanout_offsets;
+  std::vector<uint32_t> fanout;
+  std::vector<uint32_t> fanin_offsets;
+  std::vector<uint32_t> fanin;
+
+  // port name, vertex id
+  std::vector<std::pair<Symbol, uint32_t>> pi;
+  std::vector<std::pair<Symbol, uint32_t>> po;
+
+  size_t num_vertices() const;
+  size_t num_edges() const;
+
+  Span fanout_of(uint32_t) const;
+  Span fanin_of(uint32_t) const;
+
+  std::vector<uint32_t> topological_order() const;
+
+  void index();
+};
+
+// Function: num_vertices
+inline size_t CsrGraph::num_vertices() const {
+  return vertex_names.size();
+}
+
+// Function: num_edges
+inline size_t CsrGraph::num_edges() const {
+  return edge_names.size();
+}
+
+// Function: fanout_of
+inline CsrGraph::Span CsrGraph::fanout_of(uint32_t v) const {
+  return {fanout.data() + fanout_offsets[v], fanout.data() + fanout_offsets[v+1]};
+}
+
+// Function: fanin_of
+inline CsrGraph::Span CsrGraph::fanin_of(uint32_t v) const {
+  return {fanin.data() + fanin_offsets[v], fanin.data() + fanin_offsets[v+1]};
+}
+
+// Procedure: index
+// Build the fan-in/fan-out offset and edge arrays from the edge endpoints by
+// a counting sort, so edges of the same vertex are listed in edge-id order.
+inline void CsrGraph::index() {
+
+  const auto V {num_vertices()};
+  const auto E {num_edges()};
+
+  auto fill = [&] (
+    const std::vector<uint32_t>& ends,
+    std::vector<uint32_t>& offsets,
+    std::vector<uint32_t>& list
+  ) {
+    offsets.assign(V + 1, 0);
+    for(auto v : ends) {
+      if(v != NONE) ++offsets[v+1];
+    }
+    for(size_t v=0; v<V; ++v) {
+      offsets[v+1] += offsets[v];
+    }
+    list.resize(offsets[V]);
+    std::vector<uint32_t> cursor(offsets.begin(), offsets.end()-1);
+    for(uint32_t e=0; e<E; ++e) {
+      if(ends[e] != NONE) list[cursor[ends[e]]++] = e;
+    }
+  };
+
+  fill(edge_from, fanout_offsets, fanout);
+  fill(edge_to, fanin_offsets, fanin);
+}
+
+// Function: topological_order
+// Kahn's algorithm over the vertex array. Returns an empty vector if the
+// graph has a cycle.
+inline std::vector<uint32_t> CsrGraph::topological_order() const {
+
+  const auto V {num_vertices()};
+
+  std::vector<uint32_t> order;
+  std::vector<uint32_t> degree(V);
+
+  order.reserve(V);
+
+  for(uint32_t v=0; v<V; ++v) {
+    for(auto e : fanin_of(v)) {
+      if(edge_from[e] != NONE) ++degree[v];
+    }
+    if(degree[v] == 0) order.push_back(v);
+  }
+
+  for(size_t i=0; i<order.size(); ++i) {
+    for(auto e : fanout_of(order[i])) {
+      if(auto to = edge_to[e]; to != NONE and --degree[to] == 0) {
+        order.push_back(to);
+      }
+    }
+  }
+
+  if(order.size() != V) {
+    order.clear();
+  }
+
+  return order;
+}
+
+
+};  // end of namespace sda::des. -----------------------------------------------------------------
+
+#endif
@@ -20,9 +20,20 @@
 #include <iomanip>
 #include <cassert>
 #include <experimental/filesystem>
-#include <regex>
 #include <string_view>
 #include <cctype>
+#include <atomic>
+#include <sda/utility/mmap.hpp>
+#include <sda/utility/symbol.hpp>
+#include <sda/utility/path.hpp>
+#include <sda/utility/threadpool.hpp>
+#include <sda/utility/hash.hpp>
+#include <sda/utility/tokenizer.hpp>
+#include <sda/utility/writer.hpp>
+#include <sda/des/lexer.hpp>
+#include <sda/des/csr.hpp>
+#include <sda/des/desb.hpp>
+#include <sda/tech/tech.hpp>
 
 namespace std {
 
@@ -34,71 +45,157 @@ namespace sda{
 
 class Des{
 
-  enum class Keyword{
-    NONE = 0,
-    MODULE,  
-    INPUT, 
-    OUTPUT, 
-    WIRE, 
-    ENDMODULE
-  };
+  using Keyword = des::Keyword;
 
+  // All names are interned symbols (see sda/utility/symbol.hpp). An unset
+  // name is EMPTY_SYMBOL.
   struct Instance{
     Instance() = default;
 
-    std::string name;
-    std::string module_name;
+    Symbol name {EMPTY_SYMBOL};
+    Symbol module_name {EMPTY_SYMBOL};
+
+    std::unordered_map<Symbol, Symbol> pin2wire;
+    std::unordered_map<Symbol, Symbol> wire2pin;
 
-    std::unordered_map<std::string, std::string> pin2wire;
-    std::unordered_map<std::string, std::string> wire2pin;
+    bool operator == (const Instance& rhs) const {
+      return name == rhs.name and module_name == rhs.module_name and pin2wire == rhs.pin2wire;
+    }
   };
 
   struct Module{
     Module() = default;
 
-    std::string name;
+    Symbol name {EMPTY_SYMBOL};
 
-    std::unordered_set<std::string> ports;
+    std::unordered_set<Symbol> ports;
     // port name, inst name
-    std::unordered_map<std::string_view, std::string> inputs;
-    std::unordered_map<std::string_view, std::string> outputs;
+    std::unordered_map<Symbol, Symbol> inputs;
+    std::unordered_map<Symbol, Symbol> outputs;
 
     // wire name, <inst 1 name, inst 2 name>
-    std::unordered_map<std::string, std::pair<std::string, std::string>> dependency_wire;   
-    std::unordered_map<std::string, std::pair<std::string, std::string>> stream_wire;
+    std::unordered_map<Symbol, std::pair<Symbol, Symbol>> dependency_wire;   
+    std::unordered_map<Symbol, std::pair<Symbol, Symbol>> stream_wire;
+
+    std::unordered_map<Symbol, Instance> instances;
+
+    bool operator == (const Module& rhs) const {
+      return name == rhs.name and ports == rhs.ports and 
+             inputs == rhs.inputs and outputs == rhs.outputs and
+             dependency_wire == rhs.dependency_wire and stream_wire == rhs.stream_wire and
+             instances == rhs.instances;
+    }
+  };
+
+  // A parsed file: the hash of its content and the modules it defines
+  struct Source{
+    Source() = default;
+    uint64_t hash {0};
+    std::vector<Symbol> modules;
+  };
+
+  // A cell statement parsed apart from its module: the instance and the wire
+  // of each pin, in order
+  struct Cell{
+    Cell() = default;
+    Instance instance;
+    std::vector<Symbol> wires;
+  };
+
+  // A statement of a chunk of a file. Cells are parsed along with the chunk;
+  // the other statements are short and parsed when the chunks are merged.
+  struct Statement{
+    Statement() = default;
+    Keyword keyword {Keyword::NONE};
+    std::string_view text;
+    Cell cell;
+  };
 
-    std::unordered_map<std::string, Instance> instances;
+  // The statements of a chunk. A chunk is complete if it was parsed without
+  // error and, unless it is the last one, its last statement ends exactly at
+  // its end, so the next chunk starts at a statement.
+  struct Chunk{
+    Chunk() = default;
+    std::vector<Statement> statements;
+    bool complete {false};
   };
 
   struct Vertex{
     Vertex() = default;
-    std::string module_name;
-    std::unordered_set<std::string> edges;
+    Symbol module_name {EMPTY_SYMBOL};
+    std::unordered_set<Path> edges;
   };
 
   struct Edge{
     Edge() = default;
-    std::string name;
-    std::string from;
-    std::string to;
+    Path name {ROOT_PATH};
+    Path from {ROOT_PATH};
+    Path to {ROOT_PATH};
+    bool stream {false};
+  };
+
+  struct Graph;
+
+  // A module instance inside a graph: a reference to the graph of its module,
+  // which is built once and shared, plus the binding of its ports.
+  struct Child{
+    Child() = default;
+    Symbol module_name {EMPTY_SYMBOL};
+    const Graph* graph {nullptr};
+    // child port name, local wire name
+    std::unordered_map<Symbol, Symbol> binding;
   };
 
+  // The graph of a module holds its own leaf cells and wires only. Vertices
+  // in pi, po and edges are paths relative to the module, resolved down to
+  // leaf cells through the children (e.g. "u/l1/a"). A flattened graph, 
+  // built by flatten(), has no children and keys every vertex and edge by 
+  // its full path. An unresolved endpoint is ROOT_PATH.
   struct Graph{
     Graph() = default;
-    std::unordered_map<std::string, std::string> pi;
-    std::unordered_map<std::string, std::string> po;
+    std::unordered_map<Symbol, Path> pi;
+    std::unordered_map<Symbol, Path> po;
 
-    std::unordered_map<std::string, Vertex> vertices;
-    std::unordered_map<std::string, Edge> edges;
+    std::unordered_map<Path, Vertex> vertices;
+    std::unordered_map<Path, Edge> edges;
+
+    std::unordered_map<Symbol, Child> children;
+
+    des::CsrGraph freeze() const;
   };
 
   public:
-    bool parse_module(const std::filesystem::path&);
+    bool parse_module(
+      const std::filesystem::path&, 
+      unsigned = std::thread::hardware_concurrency());
+    bool parse_modules(
+      const std::vector<std::filesystem::path>&, 
+      unsigned = std::thread::hardware_concurrency());
+    bool parse_buffer(std::string_view);
+
+    bool reload(const std::filesystem::path&);
+
+    bool save_cache(const std::filesystem::path&) const;
+    bool load_cache(
+      const std::filesystem::path&, 
+      const std::vector<std::filesystem::path>&);
 
     std::string dump_module(const std::string&) const;
-    const std::unordered_map<std::string, Module>& get_all_modules() const;
+    bool dump_module(const std::string&, std::ostream&) const;
+    bool dump_module(const std::string&, int) const;
+    bool dump_all(std::ostream&, unsigned = std::thread::hardware_concurrency()) const;
+    bool dump_all(int, unsigned = std::thread::hardware_concurrency()) const;
+    const std::unordered_map<Symbol, Module>& get_all_modules() const;
+    const std::unordered_map<Symbol, Graph>& get_all_graphs() const;
 
-    void build_graph();
+    bool build_graph(unsigned = std::thread::hardware_concurrency());
+
+    bool load_tech(
+      const std::filesystem::path&,
+      unsigned = std::thread::hardware_concurrency());
+    const TechLibrary& get_tech() const;
+
+    Graph flatten(Symbol) const;
 
     void dump_graph() const;
     
@@ -108,53 +205,95 @@ class Des{
 
     const char _divider {'/'};
 
-    std::unordered_map<std::string, Vertex> _libs;
-    std::unordered_map<std::string, Graph> _graphs;
-    void _build_graph(const std::string&);
+    std::unordered_map<Symbol, Vertex> _libs;
+    TechLibrary _tech;
+    bool _check_cell(const Module&, const Instance&, bool = true) const;
+    bool _check_child(const Module&, const Instance&) const;
+
+    // How an instance is connected to a wire
+    enum class Role : uint8_t{
+      UNKNOWN = 0,
+      DRIVER,
+      SINK
+    };
+
+    Role _role(const Module&, Symbol, Symbol) const;
+    uint64_t _tech_digest() const;
+    bool _direct(const Module&, Symbol, std::pair<Symbol, Symbol>&) const;
+    std::unordered_map<Symbol, Graph> _graphs;
+    void _build_graph(Symbol);
 
-    std::unordered_map<std::string, Module> _modules;
+    std::unordered_map<Symbol, Module> _modules;
+
+    // canonical file path, source
+    std::unordered_map<std::string, Source> _sources;
+    std::string _source_key(const std::filesystem::path&) const;
+    // module name, names of the modules instantiating it
+    std::unordered_map<Symbol, std::unordered_set<Symbol>> _parents;
+
+    bool _insert(std::unordered_map<Symbol, Module>&, std::vector<Symbol>* = nullptr);
+    void _link(const Module&);
+    void _unlink(const Module&);
 
     Keyword _match_keyword(std::string_view, size_t = 0) const;
 
-    bool _next_valid_char(std::string_view, size_t&);
-    bool _keyword_module(std::string_view, Module&);
-    bool _keyword_wire(std::string_view, Module&);
-    bool _keyword_io(std::string_view, Module&);
+    bool _next_valid_char(std::string_view, size_t&) const;
+    bool _keyword_module(std::string_view, Module&) const;
+    bool _keyword_wire(std::string_view, Module&) const;
+    bool _keyword_io(std::string_view, Module&) const;
+
+    bool _parse_cell(std::string_view, Module&) const;
+    bool _lex_cell(std::string_view, Cell&) const;
+    bool _bind_cell(Cell&&, Module&) const;
+
+    bool _parse(std::string_view, std::unordered_map<Symbol, Module>&, unsigned = 1) const;
 
-    bool _parse_cell(std::string_view, Module&);
+    std::vector<size_t> _split(std::string_view, size_t) const;
+    void _parse_chunk(std::string_view, Chunk&, bool) const;
+    bool _merge_chunks(std::vector<Chunk>&, std::unordered_map<Symbol, Module>&) const;
 
-    std::vector<std::string> _split_on_space(std::string&);
+    bool _end_of_statement(des::Lexer&) const;
 
     bool _is_word_valid(std::string_view) const;
 
-    void _connect_io(
-      Module&, 
-      Graph&,
-      const std::string&, 
-      const std::string&, 
-      std::unordered_map<std::string, Graph>&,
-      bool);
+    Path _join(Path, Path) const;
+
+    void _flatten(const Graph&, Path, Graph&) const;
+
+    template <typename T>
+    static std::vector<std::pair<std::string_view, Symbol>> _sorted_names(const T&);
+
+    template <typename O>
+    void _dump_module(const Module&, O&) const;
+
+    std::vector<WriteBuffer> _dump_modules(const std::vector<Symbol>&, unsigned) const;
 
-    std::regex _del_head_tail_ws {"^[ \t\n]+|[ \t\n]+$"};
-    std::regex _ws_re {"\\s+"};
+    Symbol _find_module(const std::string&) const;
+
+    std::vector<Symbol> _sorted_modules() const;
 };
 
 
 inline void Des::check_graph() const {
-  for(const auto& [k, g]: _graphs){
+  for(const auto& kvp: _graphs){
+    const auto g {flatten(kvp.first)};
     for(const auto& [name, e]: g.edges){
-      if(!e.from.empty()){
+      if(e.from != ROOT_PATH){
         assert(g.vertices.find(e.from) != g.vertices.end());
       }
-      if(!e.to.empty()){
+      if(e.to != ROOT_PATH){
         assert(g.vertices.find(e.to) != g.vertices.end());
       }
     }
+    auto is_port = [&](Path e){
+      const auto& paths {PathTable::get()};
+      return paths.parent(e) == ROOT_PATH and 
+             (g.pi.find(paths.leaf(e)) != g.pi.end() or g.po.find(paths.leaf(e)) != g.po.end());
+    };
     for(const auto& [name, v]: g.vertices){
       for(const auto& e: v.edges){
-        if(g.pi.find(e) == g.pi.end() and g.po.find(e) == g.po.end() and
-          g.edges.find(e) == g.edges.end()){
-          std::cout << "No such edge : " << name << " e = " << e << '\n';
+        if(not is_port(e) and g.edges.find(e) == g.edges.end()){
+          std::cout << "No such edge : " << render(name) << " e = " << render(e) << '\n';
           assert(false);
         }
       }
@@ -167,21 +306,25 @@ inline void Des::dump_graph() const {
    
   const std::string edge (" -> ");
 
-  for(const auto& [k, g]: _graphs){
+  for(const auto& kvp: _graphs){
+    const auto& k {kvp.first};
+    const auto g {flatten(k)};
+
     std::ostringstream os;
 
-    os << "digraph " << k << " {\n";
+    os << "digraph " << name_of(k) << " {\n";
 
     for(const auto& [pin, v]: g.pi){
-      os << '"' << pin << '"' << " -> " << '"' << v << '"' << ";\n";
+      os << '"' << name_of(pin) << '"' << " -> " << '"' << render(v, _divider) << '"' << ";\n";
     }
 
     for(const auto& [pin, v]: g.po){
-      os << '"' << v << '"' << " -> " << '"' << pin << '"' << ";\n";
+      os << '"' << render(v, _divider) << '"' << " -> " << '"' << name_of(pin) << '"' << ";\n";
     }
 
     for(const auto& [name, e]: g.edges){
-      os << '"' << e.from << '"' << " -> " << '"' << e.to << '"' << " [label=" << '"' << name << '"' << "]\n";
+      os << '"' << render(e.from, _divider) << '"' << " -> " << '"' << render(e.to, _divider) << '"' 
+         << " [label=" << '"' << render(name, _divider) << '"' << (e.stream ? ", style=dashed" : "") << "]\n";
     }
 
     os << "}";
@@ -190,54 +333,233 @@ inline void Des::dump_graph() const {
   }
 }
 
-inline const std::unordered_map<std::string, Des::Module>& Des::get_all_modules() const {
+inline const std::unordered_map<Symbol, Des::Module>& Des::get_all_modules() const {
   return _modules;
 }
 
+inline const std::unordered_map<Symbol, Des::Graph>& Des::get_all_graphs() const {
+  return _graphs;
+}
 
-inline std::string Des::dump_module(const std::string& module_name) const {
-  if(_modules.find(module_name) == _modules.end()){
-    return std::string();
+// Function: freeze
+// Pack a flattened graph (see flatten) into contiguous CSR arrays. Vertices
+// and edges are numbered in the lexicographic order of their names so the 
+// result does not depend on hash-table iteration order.
+inline des::CsrGraph Des::Graph::freeze() const {
+  des::CsrGraph csr;
+
+  // Sort the keys of a table by name; names are resolved once per key
+  auto sorted_keys = [](const auto& table, auto&& name){
+    std::vector<std::pair<decltype(name(0)), uint32_t>> keys;
+    keys.reserve(table.size());
+    for(const auto& kvp: table){
+      keys.emplace_back(name(kvp.first), kvp.first);
+    }
+    std::sort(keys.begin(), keys.end());
+    std::vector<uint32_t> symbols(keys.size());
+    std::transform(keys.begin(), keys.end(), symbols.begin(), [](auto& k){ return k.second; });
+    return symbols;
+  };
+
+  // Vertices
+  auto path_name = [](Path p){ return render(p); };
+
+  csr.vertex_names = sorted_keys(vertices, path_name);
+
+  std::unordered_map<Path, uint32_t> ids;
+  ids.reserve(vertices.size());
+  csr.vertex_cells.reserve(vertices.size());
+  for(const auto v: csr.vertex_names){
+    ids.emplace(v, ids.size());
+    csr.vertex_cells.push_back(vertices.at(v).module_name);
+  }
+
+  auto id_of = [&](Path v){
+    auto itr = ids.find(v);
+    return itr == ids.end() ? des::CsrGraph::NONE : itr->second;
+  };
+
+  // Edges
+  csr.edge_names = sorted_keys(edges, path_name);
+
+  csr.edge_from.reserve(edges.size());
+  csr.edge_to.reserve(edges.size());
+  csr.edge_stream.reserve(edges.size());
+  for(const auto e: csr.edge_names){
+    const auto& edge {edges.at(e)};
+    csr.edge_from.push_back(id_of(edge.from));
+    csr.edge_to.push_back(id_of(edge.to));
+    csr.edge_stream.push_back(edge.stream);
   }
-  
-  std::string str;
-  auto m = _modules.at(module_name);
 
-  str.append("module ").append(m.name).append("(");
-  for(const auto& p: m.ports){
-    str.append(p).append(",\n");
+  // Primary inputs and outputs
+  for(const auto port: sorted_keys(pi, name_of)){
+    csr.pi.emplace_back(port, id_of(pi.at(port)));
   }
-  if(not m.ports.empty()){
-    str.erase(str.size()-2);
+  for(const auto port: sorted_keys(po, name_of)){
+    csr.po.emplace_back(port, id_of(po.at(port)));
   }
-  str.append(");\n");
 
-  for(const auto& p: m.inputs){
-    str.append("input ").append(p.first).append(";\n");
+  csr.index();
+
+  return csr;
+}
+
+// Function: _sorted_names
+// Return the names of the keys of a table of symbols with their symbols, in
+// lexicographic order of the names.
+template <typename T>
+std::vector<std::pair<std::string_view, Symbol>> Des::_sorted_names(const T& table){
+  std::vector<std::pair<std::string_view, Symbol>> names;
+  names.reserve(table.size());
+  for(const auto& kvp: table){
+    if constexpr(std::is_same_v<std::decay_t<decltype(kvp)>, Symbol>){
+      names.emplace_back(name_of(kvp), kvp);
+    }
+    else{
+      names.emplace_back(name_of(kvp.first), kvp.first);
+    }
   }
+  std::sort(names.begin(), names.end());
+  return names;
+}
+
+// Procedure: _dump_module
+// Write a module in des syntax. Ports, declarations, instances and pins are
+// sorted by name so the text does not depend on hash-table order.
+template <typename O>
+void Des::_dump_module(const Module& m, O& buf) const {
+
+  buf << "module " << name_of(m.name) << '(';
+  bool first {true};
+  for(const auto& kvp: _sorted_names(m.ports)){
+    buf << (first ? "" : ",\n") << kvp.first;
+    first = false;
+  }
+  buf << ");\n";
 
-  for(const auto& p: m.outputs){
-    str.append("output ").append(p.first).append(";\n");
+  for(const auto& kvp: _sorted_names(m.inputs)){
+    buf << "input " << kvp.first << ";\n";
   }
 
-  for(const auto& p: m.dependency_wire){
-    str.append("wire ").append(p.first).append(" dependency;\n");
+  for(const auto& kvp: _sorted_names(m.outputs)){
+    buf << "output " << kvp.first << ";\n";
   }
 
-  for(const auto& p: m.stream_wire){
-    str.append("wire ").append(p.first).append(" stream;\n");
+  for(const auto& kvp: _sorted_names(m.dependency_wire)){
+    buf << "wire " << kvp.first << " dependency;\n";
   }
 
-  for(const auto&[k ,v]: m.instances){
-    str.append(v.module_name).append(1, ' ').append(k).append(1, '(');
-    for(const auto& [p, w]: v.pin2wire){
-      str.append(1, '.').append(p).append(1, '(').append(w).append("), ");
+  for(const auto& kvp: _sorted_names(m.stream_wire)){
+    buf << "wire " << kvp.first << " stream;\n";
+  }
+
+  for(const auto& [name, symbol]: _sorted_names(m.instances)){
+    const auto& inst {m.instances.at(symbol)};
+    buf << name_of(inst.module_name) << ' ' << name << '(';
+    first = true;
+    for(const auto& [pin, p]: _sorted_names(inst.pin2wire)){
+      buf << (first ? "." : ", .") << pin << '(' << name_of(inst.pin2wire.at(p)) << ')';
+      first = false;
+    }
+    buf << ");\n";
+  }
+
+  buf << "endmodule\n";
+}
+
+// Function: _dump_modules
+// Write the named modules into one buffer each, in parallel. An unknown
+// name leaves its buffer empty.
+inline std::vector<WriteBuffer> Des::_dump_modules(
+  const std::vector<Symbol>& names, unsigned num_threads
+) const {
+
+  std::vector<WriteBuffer> buffers(names.size());
+
+  parallel_for(names.size(), num_threads, [&](size_t i){
+    if(auto itr = _modules.find(names[i]); itr != _modules.end()){
+      _dump_module(itr->second, buffers[i]);
     }
-    str.erase(str.size()-2);
-    str.append(");\n");
+  });
+
+  return buffers;
+}
+
+// Function: _find_module
+// Return the symbol of a parsed module, or EMPTY_SYMBOL. Names that were
+// never seen are not interned.
+inline Symbol Des::_find_module(const std::string& module_name) const {
+  if(not SymbolTable::get().contains(module_name)){
+    return EMPTY_SYMBOL;
+  }
+  const auto name {intern(module_name)};
+  return _modules.find(name) == _modules.end() ? EMPTY_SYMBOL : name;
+}
+
+// Function: _sorted_modules
+// Return the symbols of all modules in lexicographic order of their names.
+inline std::vector<Symbol> Des::_sorted_modules() const {
+  std::vector<Symbol> names;
+  for(const auto& kvp: _sorted_names(_modules)){
+    names.push_back(kvp.second);
+  }
+  return names;
+}
+
+// Function: dump_module
+// Return the text of a module, or an empty string if there is no such module.
+inline std::string Des::dump_module(const std::string& module_name) const {
+  WriteBuffer buf;
+  if(const auto name {_find_module(module_name)}; name != EMPTY_SYMBOL){
+    _dump_module(_modules.at(name), buf);
+  }
+  return std::string(buf.view());
+}
+
+// Function: dump_module
+// Stream the text of a module. Returns false if there is no such module or
+// the stream fails.
+inline bool Des::dump_module(const std::string& module_name, std::ostream& os) const {
+  const auto name {_find_module(module_name)};
+  if(name == EMPTY_SYMBOL){
+    return false;
+  }
+  WriteBuffer buf;
+  _dump_module(_modules.at(name), buf);
+  os.write(buf.data(), buf.size());
+  return os.good();
+}
+
+// Function: dump_module
+// Write the text of a module to a file descriptor. Returns false if there is
+// no such module or the write fails.
+inline bool Des::dump_module(const std::string& module_name, int fd) const {
+  const auto name {_find_module(module_name)};
+  if(name == EMPTY_SYMBOL){
+    return false;
+  }
+  Writer writer(fd);
+  _dump_module(_modules.at(name), writer);
+  return writer.close();
+}
+
+// Function: dump_all
+// Stream the text of all modules in lexicographic order of their names. The
+// modules are formatted in parallel, into one buffer each.
+inline bool Des::dump_all(std::ostream& os, unsigned num_threads) const {
+  for(const auto& buf: _dump_modules(_sorted_modules(), num_threads)){
+    os.write(buf.data(), buf.size());
   }
+  return os.good();
+}
 
-  return str.append("endmodule\n");
+// Function: dump_all
+// Write the text of all modules to a file descriptor with one writev.
+inline bool Des::dump_all(int fd, unsigned num_threads) const {
+  Writer writer(fd);
+  writer.write(_dump_modules(_sorted_modules(), num_threads));
+  return writer.close();
 }
 
 
@@ -245,111 +567,94 @@ inline std::string Des::dump_module(const std::string& module_name) const {
 // Check the chars must be either alphabets or digits or underscore
 // and the first char must be an alphabet or underscore.
 inline bool Des::_is_word_valid(std::string_view sv) const {
-  static constexpr auto is_char_valid = [](char c){return (std::isalnum(c) or c == '_');};
-  return not sv.empty() and std::all_of(sv.begin(), sv.end(), is_char_valid) and 
-    (std::isalpha(sv[0]) or sv[0] == '_');
+  return is_word(sv);
 }
 
 
 
-inline std::vector<std::string> Des::_split_on_space(std::string& s){
-  return std::vector<std::string>(std::sregex_token_iterator(s.begin(), s.end(), _ws_re, -1), {});
+// Function: _end_of_statement
+// Check nothing but an optional semicolon is left in the statement.
+inline bool Des::_end_of_statement(des::Lexer& lex) const {
+  auto tok {lex.next()};
+  if(tok.is(des::Token::Type::SEMICOLON)){
+    tok = lex.next();
+  }
+  return tok.is(des::Token::Type::END);
 }
 
-inline bool Des::_keyword_module(std::string_view buf, Module& mod){
-  size_t pos {6};  // Skip keyword "module"
 
-  // Get the name of the module
-  if(auto ret=buf.find_first_not_of(" \t\n", pos); 
-    ret == std::string::npos or ret == pos){
+// module M(a, b, c)
+inline bool Des::_keyword_module(std::string_view buf, Module& mod) const {
+  using Type = des::Token::Type;
+
+  des::Lexer lex(buf);
+
+  // Get keyword "module"
+  if(not lex.next().is(Type::KEYWORD, "module")){
     return false; // Invalid
   }
-  else{
-    pos = ret;
-  }
 
-  // Get the left and right parenthese
-  const auto l_par {buf.find_first_of('(', pos)};
-  const auto r_par {buf.find_first_of(')', pos)};
-
-  // Check unique left and right parenthese and their positions
-  if(l_par == std::string::npos or 
-     r_par == std::string::npos or 
-     l_par > r_par or
-     buf.find_first_of('(', l_par+1) != std::string::npos or 
-     buf.find_first_of(')', r_par+1) != std::string::npos){
+  // Get module name
+  auto tok {lex.next()};
+  if(not tok.is(Type::IDENTIFIER) or not _is_word_valid(tok.text)){
     return false; // Invalid
   }
+  mod.name = intern(tok.text);
 
-  // Get module name 
-  mod.name.resize(l_par-pos);
-  buf.copy(mod.name.data(), l_par-pos, pos);
-  mod.name = std::regex_replace(mod.name, _del_head_tail_ws, "$1");
-  if(mod.name.empty() or not _is_word_valid(mod.name)){
+  if(not lex.next().is(Type::LPAREN)){
     return false; // Invalid
   }
- 
+
   // Extract ports
-  pos = l_par + 1;
-  while(pos < r_par){
-    auto comma = buf.find_first_of(",)", pos);
-    if(comma == pos){ // End of buf
-      break;
+  for(tok = lex.next(); tok.is(Type::IDENTIFIER); tok = lex.next()){
+    if(not mod.ports.insert(intern(tok.text)).second){
+      return false; // Invalid: duplicate port
     }
-    std::string p(buf.data(), pos, comma-pos);
-    p = std::regex_replace(p, _del_head_tail_ws, "$1");
-    if(p.empty() or mod.ports.find(p) != mod.ports.end()){
-      return false; // Invalid
+    if(tok = lex.next(); not tok.is(Type::COMMA)){
+      break;
     }
-    mod.ports.insert(std::move(p));
-    pos = comma + 1;
   }
-  return true;
+
+  return tok.is(Type::RPAREN) and _end_of_statement(lex);
 }
 
 
 // wire my_wire dependency;
-inline bool Des::_keyword_wire(std::string_view buf, Module& mod){
+inline bool Des::_keyword_wire(std::string_view buf, Module& mod) const {
+  using Type = des::Token::Type;
+
   if(buf.find_first_of('\n') != std::string::npos){
     return false; // Invalid: should be a single line
   }
 
-  if(buf.back() == ';'){
-    buf = buf.substr(0, buf.size()-1);
-  }
+  des::Lexer lex(buf);
 
-  std::regex_token_iterator<std::string_view::iterator> end_of_buf;
-  // Get keyword "wire"
-  std::regex_token_iterator<std::string_view::iterator> iter(buf.begin(), buf.end(), _ws_re, -1);
-  if(iter == end_of_buf or iter->compare("wire") != 0){
+  // Get keyword "wire", wire name and wire type
+  if(not lex.next().is(Type::KEYWORD, "wire")){
     return false; // Invalid
   }
+  const auto name {lex.next()};
+  const auto type {lex.next()};
 
-  // Get wire name
-  if(++iter == end_of_buf){
+  if(not name.is(Type::IDENTIFIER) or 
+     not (type.is(Type::IDENTIFIER, "stream") or type.is(Type::IDENTIFIER, "dependency")) or
+     not _end_of_statement(lex)){
     return false; // Invalid
   }
-  std::string wire_name(iter->str());
 
-  // Get wire type
-  if(++iter == end_of_buf or 
-    (iter->compare("stream") != 0 and iter->compare("dependency") != 0)){
-    return false; // Invalid
-  }
-  std::string_view wire_type(iter->str());
-  
+  const auto wire_name {intern(name.text)};
+
   // Last check
-  if(++iter != end_of_buf or 
-    mod.dependency_wire.find(wire_name) != mod.dependency_wire.end() or 
-    mod.stream_wire.find(wire_name) != mod.stream_wire.end()){
+  if(mod.dependency_wire.find(wire_name) != mod.dependency_wire.end() or 
+     mod.stream_wire.find(wire_name) != mod.stream_wire.end()){
     return false; // Invalid
   }
 
-  if(wire_type.compare("stream") == 0){
-    mod.stream_wire.insert({std::move(wire_name), {}});
+  if(type.text == "stream"){
+    mod.stream_wire.insert({wire_name, {}});
   }
   else{
-    mod.dependency_wire.insert({std::move(wire_name), {}});
+    mod.dependency_wire.insert({wire_name, {}});
   }
 
   return true;
@@ -358,42 +663,36 @@ inline bool Des::_keyword_wire(std::string_view buf, Module& mod){
 
 
 // input primary_input;
-inline bool Des::_keyword_io(std::string_view buf, Module& mod){
+inline bool Des::_keyword_io(std::string_view buf, Module& mod) const {
+  using Type = des::Token::Type;
+
   if(buf.find_first_of('\n') != std::string::npos){
     return false; // Invalid: should be a single line
   }
 
-  if(buf.back() == ';'){
-    buf = buf.substr(0, buf.size()-1);
-  }
-
-  std::regex_token_iterator<std::string_view::iterator> end_of_buf;
-  std::regex_token_iterator<std::string_view::iterator> iter(buf.begin(), buf.end(), _ws_re, -1);
-  if(iter == end_of_buf or 
-    (iter->compare("input") != 0 and iter->compare("output") != 0)){
-    return false; // Invalid
-  }
+  des::Lexer lex(buf);
 
-  // Get keyword "input/output"
-  std::string_view io_type(iter->str());
+  // Get keyword "input/output" and IO name
+  const auto io_type {lex.next()};
+  const auto io_name {lex.next()};
 
-  // Get IO name
-  if(++iter == end_of_buf){
+  if(not (io_type.is(Type::KEYWORD, "input") or io_type.is(Type::KEYWORD, "output")) or
+     not io_name.is(Type::IDENTIFIER) or
+     not _end_of_statement(lex)){
     return false; // Invalid
   }
 
-  std::string io_name(iter->str());
-
   // Last check
-  if(++iter != end_of_buf or mod.ports.find(io_name) == mod.ports.end()){
+  const auto port {intern(io_name.text)};
+  if(mod.ports.find(port) == mod.ports.end()){
     return false; // Invalid
   }
 
-  if(io_type.compare("input") == 0){
-    mod.inputs.insert({*mod.ports.find(io_name), {}});
+  if(io_type.text == "input"){
+    mod.inputs.insert({port, EMPTY_SYMBOL});
   }
   else{
-    mod.outputs.insert({*mod.ports.find(io_name), {}});
+    mod.outputs.insert({port, EMPTY_SYMBOL});
   }
 
   return true;
@@ -402,51 +701,82 @@ inline bool Des::_keyword_io(std::string_view buf, Module& mod){
 
 
 // PR    A(.i(in), .o(w));
-inline bool Des::_parse_cell(std::string_view buf, Module& mod){
-  if(buf.back() == ';'){
-    buf = buf.substr(0, buf.size()-1);
-  }
+inline bool Des::_parse_cell(std::string_view buf, Module& mod) const {
+  Cell cell;
+  return _lex_cell(buf, cell) and _bind_cell(std::move(cell), mod);
+}
 
-  std::string::size_type pre_pos {0};
-  std::string::size_type pos {0};
-  if(pos = buf.find_first_of(" \t"); pos == std::string::npos){
-    return false; // Invalid
-  }
 
-  // Get cell name 
-  if(not _is_word_valid({&buf[0], pos})){
-    return false;
-  }
-  std::string module_name(&buf[0], pos);
+// Function: _lex_cell
+// Parse a cell statement without its module. Only the syntax and the names
+// are checked, so chunks of a file can be lexed in parallel.
+inline bool Des::_lex_cell(std::string_view buf, Cell& cell) const {
+  using Type = des::Token::Type;
 
-  // Move cursors to the beg/end of instance name
-  if(pre_pos = buf.find_first_not_of(" \t", pos); pre_pos == std::string::npos){
-    return false; // Invalid
-  }
-  if(pos = buf.find_first_of(" (\t", pre_pos); pos == std::string::npos){
+  des::Lexer lex(buf);
+
+  // Get cell name and instance name
+  const auto type {lex.next()};
+  const auto name {lex.next()};
+
+  if(not type.is(Type::IDENTIFIER) or not _is_word_valid(type.text) or 
+     not name.is(Type::IDENTIFIER) or not _is_word_valid(name.text) or
+     not lex.next().is(Type::LPAREN)){
     return false; // Invalid
   }
 
-  // Get instance name 
-  if(not _is_word_valid({&buf[pre_pos], pos-pre_pos})){
-    return false;
-  }
-  std::string inst_name(&buf[pre_pos], pos-pre_pos);
+  auto& inst {cell.instance};
+  inst.name = intern(name.text);
+  inst.module_name = intern(type.text);
 
-  auto [inst, inserted] = mod.instances.insert({inst_name, Instance()});
-  if(not inserted){
-    return false;
+  // Extract the pin connections: .pin(wire), ...
+  for(auto tok {lex.next()}; ; tok = lex.next()){
+    if(not tok.is(Type::DOT)){
+      return false;  // Invalid
+    }
+
+    const auto pin {lex.next()};
+    if(not pin.is(Type::IDENTIFIER) or not lex.next().is(Type::LPAREN)){
+      return false;  // Invalid
+    }
+
+    const auto wire {lex.next()};  // A wire could be an input or output
+    if(not wire.is(Type::IDENTIFIER) or not lex.next().is(Type::RPAREN)){
+      return false;  // Invalid
+    }
+
+    // Check the pin name and wire name
+    if(not _is_word_valid(pin.text) or 
+       not _is_word_valid(wire.text)){ 
+      return false;
+    }
+
+    const auto pin_name {intern(pin.text)};
+    const auto wire_name {intern(wire.text)};
+
+    inst.pin2wire.insert({pin_name, wire_name});
+    inst.wire2pin.insert({wire_name, pin_name});
+    cell.wires.push_back(wire_name);
+
+    if(tok = lex.next(); tok.is(Type::RPAREN)){
+      break;
+    }
+    if(not tok.is(Type::COMMA)){
+      return false;  // Invalid
+    }
   }
-  inst->second.name = std::move(inst_name);
-  inst->second.module_name = std::move(module_name);
 
-  std::string::size_type dot {0}; 
-  std::string::size_type l_par {0}; 
-  std::string::size_type r_par {pos}; 
+  return _end_of_statement(lex);
+}
+
+
+// Function: _bind_cell
+// Add a lexed cell to its module and connect its wires. 
+inline bool Des::_bind_cell(Cell&& cell, Module& mod) const {
 
   // A lambda to set the pin names of an edge
-  auto set_pin_name = [](std::pair<std::string, std::string>& e, std::string& pin){
-    if(e.first.empty()){
+  auto set_pin_name = [](std::pair<Symbol, Symbol>& e, Symbol pin){
+    if(e.first == EMPTY_SYMBOL){
       e.first = pin;
     }
     else{
@@ -454,97 +784,69 @@ inline bool Des::_parse_cell(std::string_view buf, Module& mod){
     }
   };
 
-  while(1){
-    if(dot = buf.find_first_of('.', r_par); dot == std::string::npos){
-      break;  // Parse end
-    }
-    if(l_par = buf.find_first_of('(', dot); 
-      l_par == std::string::npos or l_par == dot+1){
-      return false;  // Invalid
-    }
-    if(r_par = buf.find_first_of(')', l_par); 
-      r_par == std::string::npos or r_par == l_par+1){
-      return false;  // Invalid
-    }
-
-    std::string pin_name({&buf[dot+1], l_par-dot-1});
-    std::string wire_name({&buf[l_par+1], r_par-l_par-1}); // A wire could be an input or output
+  const auto name {cell.instance.name};
 
-    pin_name = std::regex_replace(pin_name, _del_head_tail_ws, "$1");
-    wire_name = std::regex_replace(wire_name, _del_head_tail_ws, "$1");
+  if(mod.instances.find(name) != mod.instances.end()){
+    return false;
+  }
 
-    // Check the pin name and wire name
-    if(not _is_word_valid(pin_name) or 
-       not _is_word_valid(wire_name)){ 
-      return false;
-    }
+  for(const auto wire_name: cell.wires){
 
     // Check wire should exist. (wire is always declared before the inst)
-    if(mod.dependency_wire.find(wire_name) == mod.dependency_wire.end()and 
-       mod.stream_wire.find(wire_name) == mod.stream_wire.end() and 
-       mod.inputs.find(wire_name) == mod.inputs.end() and 
-       mod.outputs.find(wire_name) == mod.outputs.end()){
-      return false;
+    if(auto itr = mod.inputs.find(wire_name); itr != mod.inputs.end()){
+      itr->second = name;
     }
-
-    if(mod.inputs.find(wire_name) != mod.inputs.end()){
-      mod.inputs.at(wire_name) = inst->second.name;
+    else if(auto itr = mod.outputs.find(wire_name); itr != mod.outputs.end()){
+      itr->second = name;
     }
-    else if(mod.outputs.find(wire_name) != mod.outputs.end()){
-      mod.outputs.at(wire_name) = inst->second.name;
+    else if(auto itr = mod.stream_wire.find(wire_name); itr != mod.stream_wire.end()){
+      set_pin_name(itr->second, name);
     }
-    else if(mod.stream_wire.find(wire_name) != mod.stream_wire.end()){
-      set_pin_name(mod.stream_wire.at(wire_name), inst->second.name);
+    else if(auto itr = mod.dependency_wire.find(wire_name); itr != mod.dependency_wire.end()){
+      set_pin_name(itr->second, name);
     }
     else{
-      set_pin_name(mod.dependency_wire.at(wire_name), inst->second.name);
+      return false;
     }
-
-    inst->second.pin2wire.insert({pin_name, wire_name});
-    inst->second.wire2pin.insert({wire_name, pin_name});
   }
 
-  if(inst->second.pin2wire.empty()){
-    return false; // Invalid
-  }
+  mod.instances.emplace(name, std::move(cell.instance));
+
   return true;
 }
 
 
+// Function: _match_keyword
+// Return the keyword that begins the statement at pos. The keyword must be a
+// whole word, as the lexer reads it, so a cell named "modulex" or "wire_buf"
+// is not taken for a keyword.
 inline Des::Keyword Des::_match_keyword(std::string_view buf, size_t pos) const {
-  static const std::unordered_map<std::string_view, Keyword> keywords = {
-    {"module",    Keyword::MODULE},
-    {"input",     Keyword::INPUT},
-    {"output",    Keyword::OUTPUT},
-    {"wire",      Keyword::WIRE},
-    {"endmodule", Keyword::ENDMODULE}
-  };
-
-  for(const auto& iter: keywords){
-    if(buf.compare(pos, iter.first.size(), iter.first) == 0){
-      return iter.second;
-    }
-  }
-
-  return Keyword::NONE;
+  return des::Lexer(buf.substr(pos)).next().keyword;
 }
 
 
-inline bool Des::_next_valid_char(std::string_view buf, size_t& pos){
+// Function: _next_valid_char
+// Skip whitespace and comments. Returns false if no statement is left, in 
+// which case pos is moved to the end of the buffer, or if a comment is 
+// malformed, in which case pos is left at the comment.
+inline bool Des::_next_valid_char(std::string_view buf, size_t& pos) const {
   std::string::size_type ret;
   while(pos < buf.size()){
     switch(buf[pos]){
       case '\n':
+      case '\r':
       case ' ':
       case '\t': 
-        ret=buf.find_first_not_of(" \t\n", pos+1);  // Skip all whitespace and newline
+        ret=buf.find_first_not_of(" \t\r\n", pos+1);  // Skip all whitespace and newline
         if(ret == std::string::npos){
+          pos = buf.size();
           return false;
         }
         pos = ret;
         break;
       case '#':
         if(ret=buf.find_first_of("\n", pos+1); ret == std::string::npos){
+          pos = buf.size();
           return false;
         }
         pos = ret+1;
@@ -555,13 +857,14 @@ inline bool Des::_next_valid_char(std::string_view buf, size_t& pos){
         }
         switch(buf[pos+1]){
           case '/':
-            if(ret=buf.find_first_of("\n", pos+1); ret == std::string::npos){  // Skip current line
-              return true;
+            if(ret=buf.find_first_of("\n", pos+2); ret == std::string::npos){  // Skip current line
+              pos = buf.size();
+              return false;
             }
             pos = ret+1;
             break;
           case '*':
-            if(ret=buf.find("*/", pos+1); ret == std::string::npos){
+            if(ret=buf.find("*/", pos+2); ret == std::string::npos){
               return false;
             }
             pos = ret+2;
@@ -578,38 +881,596 @@ inline bool Des::_next_valid_char(std::string_view buf, size_t& pos){
   return false;
 }
 
-inline bool Des::parse_module(const std::filesystem::path &p){
-  if(not std::filesystem::exists(p)){
-    std::cerr << "path not exists " << p << '\n';
+// Function: parse_module
+// Regular files are memory-mapped and parsed in place; pipes and stdin ("-")
+// are streamed into a buffer first. The content is only copied when a name is
+// stored into the module. A large file is split into chunks parsed by up to
+// the given number of threads.
+inline bool Des::parse_module(const std::filesystem::path &p, unsigned num_threads){
+  return parse_modules({p}, num_threads);
+}
+
+// Function: parse_modules
+// Parse files on a pool of worker threads. Each file is parsed into its own
+// module table, and the tables are merged in the order of the paths once all
+// files are parsed. A module defined more than once is reported and fails 
+// the call. Threads left over when there are fewer files than threads parse
+// chunks of the files.
+inline bool Des::parse_modules(const std::vector<std::filesystem::path>& paths, unsigned num_threads){
+  const unsigned threads_per_file = std::max<size_t>(num_threads / std::max<size_t>(paths.size(), 1), 1);
+
+  std::vector<std::unordered_map<Symbol, Module>> tables(paths.size());
+  std::vector<uint64_t> hashes(paths.size());
+  std::vector<char> parsed(paths.size(), 0);
+  std::atomic<bool> ok {true};
+
+  parallel_for(paths.size(), num_threads, [&](size_t i){
+    MappedFile file;
+    if(not file.open(paths[i])){
+      std::cerr << "failed to open " + paths[i].string() + '\n';
+      ok = false;
+      return;
+    }
+    hashes[i] = hash64(file.view());
+    if(not _parse(file.view(), tables[i], threads_per_file)){
+      std::cerr << "failed to parse " + paths[i].string() + '\n';
+      ok = false;
+    }
+    else{
+      parsed[i] = 1;
+    }
+  });
+
+  // Splice the per-file tables into the module table. Only files parsed 
+  // without error are tracked for reload.
+  for(size_t i=0; i<paths.size(); ++i){
+    std::vector<Symbol> names;
+    if(not _insert(tables[i], &names)){
+      ok = false;
+    }
+    if(parsed[i]){
+      auto& src {_sources[_source_key(paths[i])]};
+      src.hash = hashes[i];
+      src.modules = std::move(names);
+    }
+  }
+
+  return ok;
+}
+
+// Function: parse_buffer
+// Parse the modules described in an in-memory buffer. The buffer only needs
+// to outlive the call.
+inline bool Des::parse_buffer(std::string_view buffer){
+  std::unordered_map<Symbol, Module> table;
+  const auto ok {_parse(buffer, table)};
+  return _insert(table) and ok;
+}
+
+// Function: reload
+// Bring the modules and graphs up to date with the current content of a
+// file. Nothing is done if the content hash is unchanged. Otherwise the
+// modules of the file are replaced, and if graphs were built, only the graphs
+// of the modules that changed and of the modules instantiating them, 
+// transitively, are rebuilt. On error the previous state is kept. A file 
+// never seen before is simply added.
+inline bool Des::reload(const std::filesystem::path& p){
+  MappedFile file;
+  if(not file.open(p)){
+    std::cerr << "failed to open " << p << '\n';
     return false;
   }
 
-  std::ifstream ifs(p);
-  if(not ifs.good()){
+  const auto key {_source_key(p)};
+  const auto hash {hash64(file.view())};
+  const auto src {_sources.find(key)};
+
+  if(src != _sources.end() and src->second.hash == hash){
+    return true;
+  }
+
+  std::unordered_map<Symbol, Module> table;
+  if(not _parse(file.view(), table)){
+    std::cerr << "failed to parse " << p << '\n';
     return false;
   }
 
-  // Read the file to a local buffer.
-  ifs.seekg(0, std::ios::end);
-  std::string buffer(ifs.tellg(), ' ');
-  ifs.seekg(0);
-  ifs.read(&buffer[0], buffer.size());
+  std::unordered_set<Symbol> old;
+  if(src != _sources.end()){
+    old.insert(src->second.modules.begin(), src->second.modules.end());
+  }
 
-  Module mod;
-  size_t pos {0};
-  while(pos < buffer.size()){
-    // Skip whitespace and comments
-    if(not _next_valid_char(buffer, pos)){
-      //printf("fail not next valid\n");
+  for(const auto& kvp: table){
+    if(old.find(kvp.first) == old.end() and _modules.find(kvp.first) != _modules.end()){
+      std::cerr << "duplicate module " << name_of(kvp.first) << '\n';
       return false;
     }
+  }
+
+  // Modules added, removed or redefined
+  std::vector<Symbol> modified;
+  for(const auto name: old){
+    const auto itr {table.find(name)};
+    if(itr == table.end() or not (itr->second == _modules.at(name))){
+      modified.push_back(name);
+    }
+  }
+  for(const auto& kvp: table){
+    if(old.find(kvp.first) == old.end()){
+      modified.push_back(kvp.first);
+    }
+  }
+
+  // Every module whose graph depends on them
+  std::unordered_set<Symbol> affected(modified.begin(), modified.end());
+  while(not modified.empty()){
+    const auto name {modified.back()};
+    modified.pop_back();
+    if(const auto itr = _parents.find(name); itr != _parents.end()){
+      for(const auto parent: itr->second){
+        if(affected.insert(parent).second){
+          modified.push_back(parent);
+        }
+      }
+    }
+  }
+
+  // Replace the modules of the file, keeping what is replaced until the
+  // graphs are rebuilt
+  const bool existed {src != _sources.end()};
+  const auto prev_source {existed ? src->second : Source{}};
+  const auto prev_libs {_libs};
+
+  std::unordered_map<Symbol, Module> erased;
+  for(const auto name: old){
+    _unlink(_modules.at(name));
+    erased.insert(_modules.extract(name));
+  }
+
+  auto& s {_sources[key]};
+  s.hash = hash;
+  s.modules.clear();
+  _insert(table, &s.modules);
+
+  if(_graphs.empty()){
+    return true;
+  }
+
+  // Graphs referring to a dropped graph are affected as well, so none is 
+  // left dangling. Extracted nodes keep their addresses, so the child graph
+  // pointers into them stay valid if they are put back.
+  std::unordered_map<Symbol, Graph> dropped;
+  for(const auto name: affected){
+    if(auto node = _graphs.extract(name); not node.empty()){
+      dropped.insert(std::move(node));
+    }
+  }
+
+  if(build_graph()){
+    return true;
+  }
+
+  // build_graph fails before creating any graph; put the old modules back
+  for(const auto name: s.modules){
+    _unlink(_modules.at(name));
+    _modules.erase(name);
+  }
+  for(const auto& kvp: erased){
+    _link(kvp.second);
+  }
+  _modules.merge(erased);
+  _graphs.merge(dropped);
+  _libs = prev_libs;
+
+  if(existed){
+    _sources[key] = prev_source;
+  }
+  else{
+    _sources.erase(key);
+  }
+
+  return false;
+}
+
+// Function: _source_key
+// The key of a file in the source table, so that different spellings of the
+// same path refer to one source. A path that cannot be resolved is used as
+// is.
+inline std::string Des::_source_key(const std::filesystem::path& p) const {
+  std::error_code ec;
+  const auto canonical {std::filesystem::canonical(p, ec)};
+  return ec ? p.string() : canonical.string();
+}
+
+// Function: _insert
+// Move the modules of a parsed table into the module table and link them to
+// the modules they instantiate. Modules already defined stay in the table and
+// are reported. The names of the inserted modules are appended to names.
+inline bool Des::_insert(std::unordered_map<Symbol, Module>& table, std::vector<Symbol>* names){
+  std::vector<Symbol> inserted;
+  inserted.reserve(table.size());
+  for(const auto& kvp: table){
+    inserted.push_back(kvp.first);
+  }
+
+  // Nodes left behind by merge are the duplicates
+  _modules.merge(table);
+
+  bool ok {true};
+  for(const auto& kvp: table){
+    std::cerr << "duplicate module " << name_of(kvp.first) << '\n';
+    ok = false;
+  }
+
+  for(const auto name: inserted){
+    if(table.find(name) == table.end()){
+      _link(_modules.at(name));
+      _libs.erase(name);
+      if(names){
+        names->push_back(name);
+      }
+    }
+  }
+
+  return ok;
+}
+
+// Procedure: _link
+// Record a module as a parent of every cell it instantiates.
+inline void Des::_link(const Module& m){
+  for(const auto& kvp: m.instances){
+    _parents[kvp.second.module_name].insert(m.name);
+  }
+}
+
+// Procedure: _unlink
+inline void Des::_unlink(const Module& m){
+  for(const auto& kvp: m.instances){
+    if(const auto itr = _parents.find(kvp.second.module_name); itr != _parents.end()){
+      itr->second.erase(m.name);
+    }
+  }
+}
+
+// Function: save_cache
+// Write the modules, the graphs and the sources they were parsed from to a
+// .desb file (see sda/des/desb.hpp).
+inline bool Des::save_cache(const std::filesystem::path& p) const {
+  des::DesbWriter w;
+
+  auto write_map = [&](const std::unordered_map<Symbol, Symbol>& map){
+    w.word(map.size());
+    for(const auto& [k, v]: map){
+      w.symbol(k);
+      w.symbol(v);
+    }
+  };
+
+  // Sources come first so a reader can validate them before interning names
+  std::vector<const std::pair<const std::string, Source>*> sources;
+  for(const auto& kvp: _sources){
+    sources.push_back(&kvp);
+  }
+
+  w.word(sources.size());
+  for(const auto src: sources){
+    w.string(src->first);
+    w.word64(src->second.hash);
+  }
+  w.word64(_tech_digest());
+  for(const auto src: sources){
+    w.symbols(src->second.modules);
+  }
+
+  // Libs
+  w.word(_libs.size());
+  for(const auto& kvp: _libs){
+    w.symbol(kvp.first);
+  }
+
+  // Modules
+  w.word(_modules.size());
+  for(const auto& [name, m]: _modules){
+    w.symbol(name);
+    w.symbols(m.ports);
+    write_map(m.inputs);
+    write_map(m.outputs);
+    for(const auto wires: {&m.dependency_wire, &m.stream_wire}){
+      w.word(wires->size());
+      for(const auto& [wire, insts]: *wires){
+        w.symbol(wire);
+        w.symbol(insts.first);
+        w.symbol(insts.second);
+      }
+    }
+    w.word(m.instances.size());
+    for(const auto& [inst_name, inst]: m.instances){
+      w.symbol(inst_name);
+      w.symbol(inst.module_name);
+      write_map(inst.pin2wire);
+      write_map(inst.wire2pin);
+    }
+  }
+
+  // Graphs
+  w.word(_graphs.size());
+  for(const auto& [name, g]: _graphs){
+    w.symbol(name);
+    for(const auto ports: {&g.pi, &g.po}){
+      w.word(ports->size());
+      for(const auto& [port, v]: *ports){
+        w.symbol(port);
+        w.path(v);
+      }
+    }
+    w.word(g.vertices.size());
+    for(const auto& [v_name, v]: g.vertices){
+      w.path(v_name);
+      w.symbol(v.module_name);
+      w.word(v.edges.size());
+      for(const auto e: v.edges){
+        w.path(e);
+      }
+    }
+    w.word(g.edges.size());
+    for(const auto& [e_name, e]: g.edges){
+      w.path(e_name);
+      w.path(e.name);
+      w.path(e.from);
+      w.path(e.to);
+      w.word(e.stream);
+    }
+    w.word(g.children.size());
+    for(const auto& [inst_name, c]: g.children){
+      w.symbol(inst_name);
+      w.symbol(c.module_name);
+      write_map(c.binding);
+    }
+  }
+
+  return w.write(p);
+}
+
+// Function: load_cache
+// Restore the modules and graphs saved by save_cache, provided the cache was
+// written from exactly the given files, none of them has changed since, and
+// the tech library, which directs the edges, is the same. With a tech
+// library loaded, the lib cells must also pass the check of build_graph. Only an empty Des is loaded. Returns false and leaves the Des
+// untouched if the cache is missing, stale or corrupt; the files should then
+// be parsed.
+inline bool Des::load_cache(
+  const std::filesystem::path& p, 
+  const std::vector<std::filesystem::path>& paths
+){
+  if(not _modules.empty() or not _graphs.empty()){
+    return false;
+  }
+
+  des::DesbReader r;
+  if(not r.open(p)){
+    return false;
+  }
+
+  // Validate the sources
+  const size_t num_sources {r.count()};
+  if(num_sources != paths.size()){
+    return false;
+  }
+
+  std::vector<std::string> names(num_sources);
+  std::unordered_map<std::string, Source> sources;
+
+  for(size_t i=0; i<num_sources and r.good(); ++i){
+    names[i] = r.string();
+    sources[names[i]].hash = r.word64();
+  }
+
+  // Edges are directed by the pins of the tech cells
+  if(not r.good() or sources.size() != num_sources or r.word64() != _tech_digest()){
+    return false;
+  }
+
+  for(const auto& path: paths){
+    const auto src {sources.find(_source_key(path))};
+    MappedFile file;
+    if(src == sources.end() or not file.open(path) or hash64(file.view()) != src->second.hash){
+      return false;
+    }
+  }
+
+  for(size_t i=0; i<num_sources; ++i){
+    auto& modules {sources[names[i]].modules};
+    modules.resize(r.count());
+    for(auto& m: modules){
+      m = r.symbol();
+    }
+  }
+
+  auto read_map = [&](std::unordered_map<Symbol, Symbol>& map){
+    const size_t n {r.count()};
+    map.reserve(n);
+    for(size_t i=0; i<n and r.good(); ++i){
+      const auto k {r.symbol()};
+      map[k] = r.symbol();
+    }
+  };
+
+  // Libs
+  std::unordered_map<Symbol, Vertex> libs;
+  for(size_t i=0, n=r.count(); i<n and r.good(); ++i){
+    const auto name {r.symbol()};
+    libs[name].module_name = name;
+  }
+
+  // Modules
+  std::unordered_map<Symbol, Module> modules;
+  for(size_t i=0, n=r.count(); i<n and r.good(); ++i){
+    const auto name {r.symbol()};
+    auto& m {modules[name]};
+    m.name = name;
+    for(size_t j=0, k=r.count(); j<k and r.good(); ++j){
+      m.ports.insert(r.symbol());
+    }
+    read_map(m.inputs);
+    read_map(m.outputs);
+    for(const auto wires: {&m.dependency_wire, &m.stream_wire}){
+      for(size_t j=0, k=r.count(); j<k and r.good(); ++j){
+        auto& insts {(*wires)[r.symbol()]};
+        insts.first = r.symbol();
+        insts.second = r.symbol();
+      }
+    }
+    for(size_t j=0, k=r.count(); j<k and r.good(); ++j){
+      const auto inst_name {r.symbol()};
+      auto& inst {m.instances[inst_name]};
+      inst.name = inst_name;
+      inst.module_name = r.symbol();
+      read_map(inst.pin2wire);
+      read_map(inst.wire2pin);
+    }
+  }
+
+  // Graphs
+  std::unordered_map<Symbol, Graph> graphs;
+  for(size_t i=0, n=r.count(); i<n and r.good(); ++i){
+    auto& g {graphs[r.symbol()]};
+    for(const auto ports: {&g.pi, &g.po}){
+      for(size_t j=0, k=r.count(); j<k and r.good(); ++j){
+        const auto port {r.symbol()};
+        (*ports)[port] = r.path();
+      }
+    }
+    for(size_t j=0, k=r.count(); j<k and r.good(); ++j){
+      auto& v {g.vertices[r.path()]};
+      v.module_name = r.symbol();
+      for(size_t l=0, e=r.count(); l<e and r.good(); ++l){
+        v.edges.insert(r.path());
+      }
+    }
+    for(size_t j=0, k=r.count(); j<k and r.good(); ++j){
+      auto& e {g.edges[r.path()]};
+      e.name = r.path();
+      e.from = r.path();
+      e.to = r.path();
+      e.stream = r.word() != 0;
+    }
+    for(size_t j=0, k=r.count(); j<k and r.good(); ++j){
+      auto& c {g.children[r.symbol()]};
+      c.module_name = r.symbol();
+      read_map(c.binding);
+    }
+  }
+
+  if(not r.good() or not r.eof()){
+    return false;
+  }
+
+  // Resolve the shared child graphs
+  for(auto& kvp: graphs){
+    for(auto& [inst_name, c]: kvp.second.children){
+      const auto itr {graphs.find(c.module_name)};
+      if(itr == graphs.end()){
+        return false;
+      }
+      c.graph = &itr->second;
+    }
+  }
+
+  // The cache does not record the tech library, so cells are checked as
+  // build_graph would; a mismatch is left to the rebuild to report
+  if(not _tech.empty()){
+    for(const auto& kvp: modules){
+      for(const auto& inst: kvp.second.instances){
+        if(modules.find(inst.second.module_name) == modules.end() and 
+           not _check_cell(kvp.second, inst.second, false)){
+          return false;
+        }
+      }
+    }
+  }
+
+  // Nodes, hence the child graph pointers, survive the moves
+  _libs = std::move(libs);
+  _modules = std::move(modules);
+  _graphs = std::move(graphs);
+  _sources = std::move(sources);
+
+  for(const auto& kvp: _modules){
+    _link(kvp.second);
+  }
+
+  return true;
+}
+
+// Function: _parse
+// Parse the modules of a buffer into the given module table. With more than
+// one thread, a buffer of several megabytes is split into chunks at 
+// statement boundaries and the chunks are parsed in parallel. The result is
+// the same as the sequential parse.
+inline bool Des::_parse(
+  std::string_view buffer, 
+  std::unordered_map<Symbol, Module>& modules,
+  unsigned num_threads
+) const {
+
+  // Smallest chunk worth a thread
+  constexpr size_t min_chunk_size {1 << 20};
+
+  num_threads = std::clamp<size_t>(num_threads, 1, buffer.size() / min_chunk_size);
+
+  if(num_threads > 1){
+    const auto bounds {_split(buffer, num_threads)};
+    std::vector<Chunk> chunks(bounds.size() - 1);
+
+    parallel_for(chunks.size(), num_threads, [&](size_t i){
+      const auto chunk {buffer.substr(bounds[i], bounds[i+1] - bounds[i])};
+      _parse_chunk(chunk, chunks[i], i + 1 == chunks.size());
+    });
+
+    // A chunk that does not end at a statement was split inside a comment; 
+    // the rest of the buffer is parsed again in one piece
+    for(size_t i=0; i+1<chunks.size(); ++i){
+      if(not chunks[i].complete){
+        chunks.resize(i + 1);
+        chunks[i] = Chunk();
+        _parse_chunk(buffer.substr(bounds[i]), chunks[i], true);
+        break;
+      }
+    }
+
+    return _merge_chunks(chunks, modules);
+  }
+
+  Module mod;
+  bool within_module {false};
+  size_t pos {0};
+
+  // Skip whitespace and comments
+  while(_next_valid_char(buffer, pos)){
 
     // Retrieve keyword
     auto keyword=_match_keyword(buffer, pos);
 
+    // Only a module can begin outside a module and modules do not nest
+    if(within_module == (keyword == Keyword::MODULE)){
+      return false;
+    }
+
+    // Commit the module as soon as it closes so only one module is held
+    if(keyword == Keyword::ENDMODULE){
+      if(not modules.try_emplace(mod.name, std::move(mod)).second){
+        std::cerr << "duplicate module " << name_of(mod.name) << '\n';
+        return false;
+      }
+      mod = Module();
+      within_module = false;
+      pos += std::string_view("endmodule").size();
+      continue;
+    }
+
     // Find semicolon position 
     const auto semicol_pos {buffer.find_first_of(';', pos)};
-    if(keyword != Keyword::ENDMODULE and semicol_pos == std::string::npos){
+    if(semicol_pos == std::string::npos){
       return false;
     }
 
@@ -617,363 +1478,607 @@ inline bool Des::parse_module(const std::filesystem::path &p){
     switch(keyword){
       case Keyword::MODULE:
         if(not _keyword_module({&buffer[pos], semicol_pos-pos}, mod)){
-          //std::cout << std::string_view(&buffer[pos], semicol_pos-pos) << "\n";
-          //printf("fail module\n");
           return false;
         }
-        //printf("ok module\n");
-        pos = semicol_pos+1;
+        within_module = true;
         break;
       case Keyword::INPUT:
       case Keyword::OUTPUT:           
         if(not _keyword_io({&buffer[pos], semicol_pos-pos}, mod)){ 
-          //printf("fail io\n");
           return false;
         }
-        //printf("ok io\n");
-        pos = semicol_pos+1;
         break;
       case Keyword::WIRE:
         if(not _keyword_wire({&buffer[pos], semicol_pos-pos}, mod)){
-          //printf("fail wire\n");
           return false;
         }
-        pos = semicol_pos+1;
-        break;
-      case Keyword::ENDMODULE:
-        pos = buffer.size();
         break;
       default:
         if(not _parse_cell({&buffer[pos], semicol_pos-pos}, mod)){
-          //printf("fail cell\n");
-          //std::cout << std::string_view(&buffer[pos], semicol_pos-pos) << "\n";
           return false;
         }
-        pos = semicol_pos+1;
         break;
     }
+    pos = semicol_pos+1;
   }
-  _modules.insert({mod.name, std::move(mod)});
-  return true;
+
+  // Only whitespace and comments may follow the last module
+  return pos == buffer.size() and not within_module;
 }
 
 
-// ----------------------------------------------------------------------------------------------- 
+// Function: _split
+// Return the bounds of about n chunks of a buffer. Each chunk but the last
+// ends right after a semicolon. The pre-scan is speculative: a semicolon on a
+// line with a line comment is passed over, but one inside a block comment is
+// not detected here; _parse_chunk finds such a chunk incomplete.
+inline std::vector<size_t> Des::_split(std::string_view buffer, size_t n) const {
 
+  std::vector<size_t> bounds {0};
 
-inline void Des::build_graph(){
-  // Collect lib graphs
-  for(const auto& m: _modules){
-    for(const auto& inst: m.second.instances){
-      if(_modules.find(inst.second.module_name) == _modules.end() and 
-        _libs.find(inst.second.module_name) == _libs.end()){
-        _libs.insert({inst.second.module_name, {}});
+  for(size_t k=1; k<n; ++k){
+    auto pos {std::max(k * (buffer.size() / n), bounds.back())};
+    while((pos = buffer.find(';', pos)) != std::string_view::npos){
+      const auto line {buffer.rfind('\n', pos)};
+      const auto beg {line == std::string_view::npos ? 0 : line + 1};
+      const auto head {buffer.substr(beg, pos - beg)};
+      if(head.find('#') == std::string_view::npos and head.find("//") == std::string_view::npos){
+        break;
       }
+      ++pos;
     }
-  }
-
-  // Recursively build graph for each module
-  for(const auto& m: _modules){
-    if(_graphs.find(m.first) == _graphs.end()){
-      _build_graph(m.first);
+    if(pos == std::string_view::npos or pos + 1 >= buffer.size()){
+      break;
     }
+    bounds.push_back(pos + 1);
   }
-}
 
-template <typename T>
-void prefix_key(std::string prefix, std::unordered_map<std::string, T>& m){
-  for(auto& iter: m){
-    auto nh = m.extract(iter.first);
-    nh.key() = prefix+ "-" + iter.first;
-    m.insert(move(nh));
-  }
-}
+  bounds.push_back(buffer.size());
 
-template <typename T>
-void replace_key(const std::string& old_key, const std::string& new_key, 
-  std::unordered_map<std::string, T>& m){
-  auto nh = m.extract(old_key);
-  nh.key() = new_key;
-  m.insert(move(nh));
+  return bounds;
 }
 
+// Procedure: _parse_chunk
+// Split a chunk into statements and lex its cells, stopping at the first
+// error. Checks that depend on the enclosing module are left to 
+// _merge_chunks.
+inline void Des::_parse_chunk(std::string_view chunk, Chunk& c, bool last) const {
+
+  size_t pos {0};
+  bool at_statement {false};
 
+  c.complete = false;
 
-inline void Des::_connect_io(
-  Module &m, 
-  Graph &g,
-  const std::string& wire_name, 
-  const std::string& inst_name, 
-  std::unordered_map<std::string, Graph>& subgraphs,
-  bool direction)
-{
-  if(g.vertices.find(inst_name) != g.vertices.end()){
-    //std::cout << inst_name << " Lib Cell\n";
-    // This is a lib cell  
+  while(_next_valid_char(chunk, pos)){
 
-    // Add edge to the vertex
-    g.vertices.at(inst_name).edges.emplace(wire_name);
+    auto& stmt {c.statements.emplace_back()};
+    stmt.keyword = _match_keyword(chunk, pos);
 
-    // Add vertex to the egde
-    if(direction){
-      g.pi.at(wire_name) = inst_name; //({wire_name, inst_name});
+    if(stmt.keyword == Keyword::ENDMODULE){
+      pos += std::string_view("endmodule").size();
+      at_statement = false;
+      continue;
     }
-    else{
-      g.po.at(wire_name) = inst_name; //g.po.insert({wire_name, inst_name});
+
+    const auto semicol_pos {chunk.find_first_of(';', pos)};
+    if(semicol_pos == std::string::npos){
+      c.statements.pop_back();
+      return;
+    }
+
+    stmt.text = chunk.substr(pos, semicol_pos-pos);
+
+    if(stmt.keyword == Keyword::NONE and not _lex_cell(stmt.text, stmt.cell)){
+      c.statements.pop_back();
+      return;
     }
-    //Edge e;
-    //e.from = inst_name;
-    //g.edges.insert({wire_name, std::move(e)});
+
+    pos = semicol_pos+1;
+    at_statement = true;
   }
-  else{
-    std::cout << inst_name << " Module Cell\n";
-    // This is a module's graph 
-    const auto& inst {m.instances.at(inst_name)};   
-    const auto& pin {inst.wire2pin.at(wire_name)};
-    {
-      auto edge_iter = direction ? g.pi.find(wire_name) : g.po.find(wire_name);
 
-      auto& inst_g {subgraphs.at(inst_name)};
-      auto& v {inst_g.vertices.at(direction ? inst_g.pi.at(pin) : inst_g.po.at(pin))};
+  c.complete = (pos == chunk.size()) and (last or at_statement);
+}
+
+// Function: _merge_chunks
+// Replay the statements of the chunks in order into the module table, with
+// the same checks and the same result as the sequential parse.
+inline bool Des::_merge_chunks(
+  std::vector<Chunk>& chunks, 
+  std::unordered_map<Symbol, Module>& modules
+) const {
+  Module mod;
+  bool within_module {false};
+
+  for(auto& chunk: chunks){
+    for(auto& stmt: chunk.statements){
 
-      if(direction){
-        //edge_iter->second = inst_name + _modules.at(inst.module_name).inputs.at(pin);
-        edge_iter->second = inst_name + _divider + inst_g.pi.at(pin);
-        //_modules.at(inst.module_name).inputs.at(pin);
+      // Only a module can begin outside a module and modules do not nest
+      if(within_module == (stmt.keyword == Keyword::MODULE)){
+        return false;
       }
-      else{
-        //edge_iter->second = inst_name + _modules.at(inst.module_name).outputs.at(pin); 
-        edge_iter->second = inst_name + _divider + inst_g.po.at(pin);
+
+      switch(stmt.keyword){
+        case Keyword::ENDMODULE:
+          if(not modules.try_emplace(mod.name, std::move(mod)).second){
+            std::cerr << "duplicate module " << name_of(mod.name) << '\n';
+            return false;
+          }
+          mod = Module();
+          within_module = false;
+          break;
+        case Keyword::MODULE:
+          if(not _keyword_module(stmt.text, mod)){
+            return false;
+          }
+          within_module = true;
+          break;
+        case Keyword::INPUT:
+        case Keyword::OUTPUT:
+          if(not _keyword_io(stmt.text, mod)){
+            return false;
+          }
+          break;
+        case Keyword::WIRE:
+          if(not _keyword_wire(stmt.text, mod)){
+            return false;
+          }
+          break;
+        default:
+          if(not _bind_cell(std::move(stmt.cell), mod)){
+            return false;
+          }
+          break;
       }
-      //std::cout << "edge_iter second => " << edge_iter->second << '\n';
-      
-      v.edges.erase(pin);
-      v.edges.insert(wire_name);
     }
-
-
-    //  // Update the PI/PO name
-    //  replace_key<std::string>(pin, wire_name, direction ? inst_g.pi : inst_g.po);
-    //}
   }
-}
 
+  return chunks.back().complete and not within_module;
+}
 
 
+// ----------------------------------------------------------------------------------------------- 
 
 
-inline void Des::_build_graph(const std::string& module_name){
-  std::cout << "Build Graph ==========> " << module_name << '\n';
-  _graphs.insert({module_name, {}});
-  auto& g {_graphs.find(module_name)->second};
-  auto& m {_modules.find(module_name)->second};
+// Function: load_tech
+// Load the cells of a .tech file, or of every .tech file under a directory,
+// into the tech library of the parser. Lib cells instantiated by modules are
+// then checked against the library by build_graph.
+inline bool Des::load_tech(const std::filesystem::path& path, unsigned num_threads){
+  return _tech.load(path, num_threads);
+}
 
-  // 1. Iterate through the module's instances
-  // 2. For each instance, check it's type ?
-  //      Lib -> get the vertex 
-  //      Module -> has graph ?
-  //                Yes:  
-  //                No:   Recursive build its graph 
-  std::unordered_map<std::string, Graph> subgraphs;
+inline const TechLibrary& Des::get_tech() const {
+  return _tech;
+}
 
-  auto collect_subgraphs {
-    [&](const Instance& inst){ 
-      if(_libs.find(inst.module_name) != _libs.end()){
-        // This is a tech lib cell 
-        if(g.vertices.find(inst.name) == g.vertices.end()){
-          // Insert the vertex of tech lib into graph
-          g.vertices.insert({inst.name, _libs.at(inst.module_name)});
-        }
+// Function: _check_cell
+// Check a lib cell instance against the tech library: the cell must be
+// described and bind only pins that the cell has, each to a wire of the
+// pin's type (stream or dependency). An input port of the module cannot be
+// bound to an output pin, nor an output port to an input pin. Errors are
+// reported unless report is false.
+inline bool Des::_check_cell(const Module& m, const Instance& inst, bool report) const {
+  const auto cell {_tech.find(inst.module_name)};
+  if(cell == nullptr){
+    if(not report){
+      return false;
+    }
+    std::cerr << "module " << name_of(m.name) << ": no tech cell " 
+              << name_of(inst.module_name) << " for instance " << name_of(inst.name) << '\n';
+    return false;
+  }
+  for(const auto& kvp: inst.pin2wire){
+    if(cell->pin(kvp.first) == nullptr){
+      if(not report){
+        return false;
       }
-      else{
-        // This is a module
-        if(subgraphs.find(inst.name) == subgraphs.end()){
-          // If the module's graph does not exist, build it recursively 
-          if(_graphs.find(inst.module_name) == _graphs.end()){
-            _build_graph(inst.module_name);
-          }
-          subgraphs.insert({inst.name, _graphs.at(inst.module_name)});
-        }
+      std::cerr << "module " << name_of(m.name) << ": tech cell " << name_of(cell->name)
+                << " has no pin " << name_of(kvp.first) << " (instance " << name_of(inst.name) << ")\n";
+      return false;
+    }
+  }
+  for(const auto& [pin_name, wire_name]: inst.pin2wire){
+    const auto pin {cell->pin(pin_name)};
+    const char* error {nullptr};
+    if(m.stream_wire.find(wire_name) != m.stream_wire.end() and pin->type != TechPin::Type::STREAM){
+      error = " is a dependency pin on stream wire ";
+    }
+    else if(m.dependency_wire.find(wire_name) != m.dependency_wire.end() and pin->type != TechPin::Type::DEPENDENCY){
+      error = " is a stream pin on dependency wire ";
+    }
+    else if(m.inputs.find(wire_name) != m.inputs.end() and pin->direction == TechPin::Direction::OUT){
+      error = " is an output pin on input port ";
+    }
+    else if(m.outputs.find(wire_name) != m.outputs.end() and pin->direction == TechPin::Direction::IN){
+      error = " is an input pin on output port ";
+    }
+    if(error != nullptr){
+      if(report){
+        std::cerr << "module " << name_of(m.name) << ": pin " << name_of(pin_name) << " of tech cell "
+                  << name_of(cell->name) << error << name_of(wire_name) << " (instance " << name_of(inst.name) << ")\n";
       }
+      return false;
     }
-  };
+  }
+  return true;
+}
 
-  for(const auto& [port_name, inst_name]: m.inputs){
-    const auto& inst {m.instances.at(inst_name)};
-    collect_subgraphs(inst);
-    g.pi.insert({port_name.data(), {}});
+// Function: _check_child
+// Check a module instance against its module: every pin must be an input or
+// an output port of the module, and an input port of m cannot be bound to an
+// output of the child, nor an output port of m to an input of the child.
+inline bool Des::_check_child(const Module& m, const Instance& inst) const {
+  const auto& child {_modules.at(inst.module_name)};
+  for(const auto& kvp: inst.pin2wire){
+    if(child.inputs.find(kvp.first) == child.inputs.end() and 
+       child.outputs.find(kvp.first) == child.outputs.end()){
+      std::cerr << "module " << name_of(m.name) << ": module " << name_of(child.name)
+                << " has no port " << name_of(kvp.first) << " (instance " << name_of(inst.name) << ")\n";
+      return false;
+    }
+    const bool child_input {child.inputs.find(kvp.first) != child.inputs.end()};
+    if((not child_input and m.inputs.find(kvp.second) != m.inputs.end()) or
+       (child_input and m.outputs.find(kvp.second) != m.outputs.end())){
+      std::cerr << "module " << name_of(m.name) << ": port " << name_of(kvp.second) << " is bound to "
+                << (child_input ? "input " : "output ") << name_of(kvp.first) << " of module "
+                << name_of(child.name) << " (instance " << name_of(inst.name) << ")\n";
+      return false;
+    }
   }
+  return true;
+}
 
-  for(const auto& [port_name, inst_name]: m.outputs){
-    const auto& inst {m.instances.at(inst_name)};
-    collect_subgraphs(inst);
-    g.po.insert({port_name.data(), {}});
+// Function: _tech_digest
+// Identify the tech library a cache was written with, by the names of its
+// cells and the hashes of their files.
+inline uint64_t Des::_tech_digest() const {
+  std::string digest;
+  for(const auto& cell: _tech.cells()){
+    digest.append(name_of(cell.name));
+    digest.push_back('\0');
+    digest.append(std::to_string(cell.hash));
+    digest.push_back('\0');
+  }
+  return hash64(digest);
+}
+
+// Function: _role
+// Whether an instance drives a wire or is driven by it, by the direction of
+// the pin on the wire: a port of a child module, or a pin of the tech cell.
+// The role of a lib cell is unknown without a tech library, and for an
+// inout pin.
+inline Des::Role Des::_role(const Module& m, Symbol inst_name, Symbol wire) const {
+  const auto& inst {m.instances.at(inst_name)};
+  const auto pin {inst.wire2pin.at(wire)};
+
+  if(const auto child = _modules.find(inst.module_name); child != _modules.end()){
+    return child->second.inputs.find(pin) != child->second.inputs.end() ? Role::SINK : Role::DRIVER;
   }
 
+  const auto cell {_tech.find(inst.module_name)};
+  const auto tech_pin {cell == nullptr ? nullptr : cell->pin(pin)};
 
-  for(const auto& kvp: m.dependency_wire){
-    const auto& [inst1, inst2] = kvp.second;
-    collect_subgraphs(m.instances.at(inst1));
-    collect_subgraphs(m.instances.at(inst2));
+  if(tech_pin == nullptr){
+    return Role::UNKNOWN;
   }
 
-  for(const auto& kvp: m.stream_wire){
-    const auto& [inst1, inst2] = kvp.second;
-    collect_subgraphs(m.instances.at(inst1));
-    collect_subgraphs(m.instances.at(inst2));
+  switch(tech_pin->direction){
+    case TechPin::Direction::IN:
+      return Role::SINK;
+    case TechPin::Direction::OUT:
+      return Role::DRIVER;
+    default:
+      return Role::UNKNOWN;
   }
+}
 
+// Function: _direct
+// Order the instances on a wire as its driver and its sink by their roles,
+// so the edge does not depend on the order of the statements. An unknown
+// role takes the one left over; if both are unknown, the first instance
+// drives the wire. Returns false if both drive the wire, in which case the
+// first is not EMPTY_SYMBOL, or if the wire has a sink and no driver.
+inline bool Des::_direct(const Module& m, Symbol wire, std::pair<Symbol, Symbol>& insts) const {
+  auto& [driver, sink] = insts;
+
+  auto role = [&](Symbol inst){
+    return inst == EMPTY_SYMBOL ? Role::UNKNOWN : _role(m, inst, wire);
+  };
 
-  //std::cout << "Start building " << module_name << '\n';
+  const auto r1 {role(driver)};
+  const auto r2 {role(sink)};
 
-  //------------------ Iterate through wires to build connection of graph  ------------------------
+  if(r1 == Role::DRIVER and r2 == Role::DRIVER){
+    return false;
+  }
 
-  // Handle primary inputs
-  for(const auto& [port_name, inst_name]: m.inputs){
-    _connect_io(m, g, port_name.data(), inst_name, subgraphs, true);    
-  } 
+  if(r1 == Role::SINK and r2 == Role::SINK){
+    driver = EMPTY_SYMBOL;
+    return false;
+  }
 
-  // Handle primary inputs
-  for(const auto& [port_name, inst_name]: m.outputs){
-    _connect_io(m, g, port_name.data(), inst_name, subgraphs, false);    
-  } 
+  if(r1 == Role::SINK or r2 == Role::DRIVER){
+    std::swap(driver, sink);
+  }
 
+  // A lone sink
+  return driver != EMPTY_SYMBOL or sink == EMPTY_SYMBOL;
+}
 
-  // Handle dependency wire
-  for(const auto& [wire_name, inst_pair]: m.dependency_wire){
-    const auto& inst1 {m.instances.at(std::get<0>(inst_pair))};
-    const auto& inst2 {m.instances.at(std::get<1>(inst_pair))};
+// Function: build_graph
+// Build the graph of every module not built yet. Modules are built bottom-up
+// along the instantiation DAG on a work-stealing pool; a module is scheduled
+// as soon as the graphs of the modules it instantiates are done, so unrelated
+// modules are built in parallel. Returns false if a module instantiates 
+// itself, directly or not, binds a pin its cell or module does not have, or
+// has a wire without exactly one driver; nothing is built then.
+inline bool Des::build_graph(unsigned num_threads){
+  // Collect lib graphs, checked against the tech library once one is loaded.
+  // Module instances are checked against their modules here, since a bad
+  // binding must not reach the workers.
+  bool ok {true};
+  for(const auto& m: _modules){
+    for(const auto& inst: m.second.instances){
+      if(_modules.find(inst.second.module_name) != _modules.end()){
+        if(not _check_child(m.second, inst.second)){
+          ok = false;
+        }
+        continue;
+      }
+      if(not _tech.empty() and not _check_cell(m.second, inst.second)){
+        ok = false;
+      }
+      if(_libs.find(inst.second.module_name) == _libs.end()){
+        _libs[inst.second.module_name].module_name = inst.second.module_name;
+      }
+    }
+  }
 
-    auto edge_iter = std::get<0>(g.edges.insert({wire_name, {}}));
+  // Every wire needs one driver, given by the pins on it
+  for(const auto& m: _modules){
+    for(const auto wires: {&m.second.dependency_wire, &m.second.stream_wire}){
+      for(const auto& [wire_name, inst_pair]: *wires){
+        auto insts {inst_pair};
+        if(not _direct(m.second, wire_name, insts)){
+          std::cerr << "module " << name_of(m.first) << ": wire " << name_of(wire_name)
+                    << (insts.first == EMPTY_SYMBOL ? " has no driver\n" : " has two drivers\n");
+          ok = false;
+        }
+      }
+    }
+  }
 
-    std::cout << "inst1 : " << inst1.module_name << '\n';
-    std::cout << "inst2 : " << inst2.module_name << '\n';
+  if(not ok){
+    return false;
+  }
 
-    // Handle inst1
-    if(_libs.find(inst1.module_name) != _libs.end()){
-      // A tech lib 
-      edge_iter->second.from = std::get<0>(inst_pair);
-      g.vertices.at(std::get<0>(inst_pair)).edges.emplace(wire_name);
+  // Number the modules to build and link each child module to its parents
+  std::vector<Symbol> names;
+  std::unordered_map<Symbol, size_t> ids;
+  for(const auto& kvp: _modules){
+    if(_graphs.find(kvp.first) == _graphs.end()){
+      ids.emplace(kvp.first, names.size());
+      names.push_back(kvp.first);
     }
-    else{
-      // A module's graph  
-      auto& pin {m.instances.at(std::get<0>(inst_pair)).wire2pin.at(wire_name)};
-      auto& inst_g {subgraphs.at(std::get<0>(inst_pair))};
-
-      if(_modules.at(inst1.module_name).inputs.find(pin) != 
-         _modules.at(inst1.module_name).inputs.end()){
-        // This is the input of the instance 
+  }
 
-        // Update the vertex name in edge 
-        edge_iter->second.to = std::get<0>(inst_pair) + _divider + inst_g.pi.at(pin);
+  std::vector<std::vector<size_t>> parents(names.size());
+  std::vector<size_t> num_children(names.size(), 0);
 
-        // Update the edge name in vertex
-        inst_g.vertices.at(inst_g.pi.at(pin)).edges.erase(pin); 
-        inst_g.vertices.at(inst_g.pi.at(pin)).edges.emplace(wire_name);
+  for(size_t i=0; i<names.size(); ++i){
+    std::unordered_set<Symbol> children;
+    for(const auto& kvp: _modules.at(names[i]).instances){
+      const auto c {ids.find(kvp.second.module_name)};
+      if(c != ids.end() and children.insert(c->first).second){
+        parents[c->second].push_back(i);
+      }
+    }
+    num_children[i] = children.size();
+  }
 
-        // Update the edge name in pi
-        replace_key(pin, wire_name, inst_g.pi); 
+  // Reject recursive instantiation
+  {
+    std::vector<size_t> degree(num_children);
+    std::vector<size_t> order;
+    order.reserve(names.size());
+    for(size_t i=0; i<names.size(); ++i){
+      if(degree[i] == 0){
+        order.push_back(i);
+      }
+    }
+    for(size_t k=0; k<order.size(); ++k){
+      for(const auto p: parents[order[k]]){
+        if(--degree[p] == 0){
+          order.push_back(p);
+        }
+      }
+    }
+    if(order.size() != names.size()){
+      for(size_t i=0; i<names.size(); ++i){
+        if(degree[i] != 0){
+          std::cerr << "recursive instantiation in module " << name_of(names[i]) << '\n';
+        }
       }
-      else{
-        edge_iter->second.from = std::get<0>(inst_pair) + _divider + inst_g.po.at(pin);
+      return false;
+    }
+  }
 
-        inst_g.vertices.at(inst_g.po.at(pin)).edges.erase(pin); 
-        inst_g.vertices.at(inst_g.po.at(pin)).edges.emplace(wire_name);
+  // Graphs are created up front so workers only look them up
+  std::vector<std::atomic<size_t>> pending(names.size());
+  for(size_t i=0; i<names.size(); ++i){
+    pending[i] = num_children[i];
+    _graphs[names[i]];
+  }
+
+  Threadpool pool(num_threads);
 
-        replace_key(pin, wire_name, inst_g.po);
+  std::function<void(size_t)> build = [&](size_t i){
+    _build_graph(names[i]);
+    for(const auto p: parents[i]){
+      if(--pending[p] == 0){
+        pool.silent_async([&build, p](){ build(p); });
       }
     }
+  };
 
-    // Handle inst2
-    if(_libs.find(inst2.module_name) != _libs.end()){
-      // A tech lib 
-      if(edge_iter->second.to.empty()){
-        edge_iter->second.to = std::get<1>(inst_pair);
-      }
-      else{
-        edge_iter->second.from = std::get<1>(inst_pair);
+  for(size_t i=0; i<names.size(); ++i){
+    if(num_children[i] == 0){
+      pool.silent_async([&build, i](){ build(i); });
+    }
+  }
+
+  pool.wait_for_all();
+
+  return true;
+}
+
+// Function: _join
+// Re-root a relative path under a prefix. An unresolved (root) path stays
+// unresolved.
+inline Path Des::_join(Path prefix, Path path) const {
+  if(path == ROOT_PATH){
+    return ROOT_PATH;
+  }
+  return PathTable::get().append(prefix, path);
+}
+
+
+// Procedure: _build_graph
+// Build the graph of a module on top of the graphs of its child modules,
+// which must be built already and are referenced rather than copied. Only
+// the graph of this module is written.
+inline void Des::_build_graph(Symbol module_name){
+  auto& g {_graphs.at(module_name)};
+  const auto& m {_modules.at(module_name)};
+
+  // Tech lib cells become vertices; module instances refer to the graph of
+  // their module
+  for(const auto& [inst_name, inst]: m.instances){
+    if(_libs.find(inst.module_name) != _libs.end()){
+      auto& v {g.vertices[path_of(inst_name)]};
+      v.module_name = inst.module_name;
+      for(const auto& [pin, wire]: inst.pin2wire){
+        if(m.dependency_wire.find(wire) != m.dependency_wire.end() or 
+           m.stream_wire.find(wire) != m.stream_wire.end() or
+           m.inputs.find(wire) != m.inputs.end() or
+           m.outputs.find(wire) != m.outputs.end()){
+          v.edges.insert(path_of(wire));
+        }
       }
-      g.vertices.at(std::get<1>(inst_pair)).edges.emplace(wire_name);
     }
     else{
-      auto& pin {m.instances.at(std::get<1>(inst_pair)).wire2pin.at(wire_name)};
-      auto& inst_g {subgraphs.at(std::get<1>(inst_pair))};
+      auto& child {g.children[inst_name]};
+      child.module_name = inst.module_name;
+      child.graph = &_graphs.at(inst.module_name);
+      child.binding = inst.pin2wire;
+    }
+  }
 
-      if(_modules.at(inst2.module_name).inputs.find(pin) != 
-         _modules.at(inst2.module_name).inputs.end()){
-        // This is the input of the instance 
+  // The vertex a wire reaches through an instance
+  auto endpoint = [&](Symbol inst_name, Symbol wire) -> Path {
+    const auto c {g.children.find(inst_name)};
+    if(c == g.children.end()){
+      return path_of(inst_name);
+    }
+    const auto pin {m.instances.at(inst_name).wire2pin.at(wire)};
+    const auto& cg {*c->second.graph};
+    if(const auto itr = cg.pi.find(pin); itr != cg.pi.end()){
+      return _join(path_of(inst_name), itr->second);
+    }
+    return _join(path_of(inst_name), cg.po.at(pin));
+  };
 
-        // Update the vertex name in edge 
-        edge_iter->second.to = std::get<1>(inst_pair) + _divider + inst_g.pi.at(pin);
+  // Handle primary inputs and outputs
+  for(const auto& [port_name, inst_name]: m.inputs){
+    g.pi[port_name] = inst_name == EMPTY_SYMBOL ? ROOT_PATH : endpoint(inst_name, port_name);
+  }
 
-        // Update the edge name in vertex
-        inst_g.vertices.at(inst_g.pi.at(pin)).edges.erase(pin); 
-        inst_g.vertices.at(inst_g.pi.at(pin)).edges.emplace(wire_name);
+  for(const auto& [port_name, inst_name]: m.outputs){
+    g.po[port_name] = inst_name == EMPTY_SYMBOL ? ROOT_PATH : endpoint(inst_name, port_name);
+  }
 
-        // Update the edge name in pi 
-        replace_key<std::string>(pin, wire_name, inst_g.pi); 
-      }
-      else{
-        edge_iter->second.from = std::get<1>(inst_pair) + _divider + inst_g.po.at(pin);
+  // Handle dependency and stream wires; a stream wire connects cells that
+  // run together rather than one after the other. The driver of a wire,
+  // checked by build_graph, is its source.
+  for(const auto wires: {&m.dependency_wire, &m.stream_wire}){
+    for(const auto& [wire_name, inst_pair]: *wires){
 
-        inst_g.vertices.at(inst_g.po.at(pin)).edges.erase(pin); 
-        inst_g.vertices.at(inst_g.po.at(pin)).edges.emplace(wire_name);
+      auto insts {inst_pair};
+      _direct(m, wire_name, insts);
 
-        replace_key<std::string>(pin, wire_name, inst_g.po);
-      }
-    }
-  } 
+      auto& e {g.edges[path_of(wire_name)]};
+      e.name = path_of(wire_name);
+      e.stream = (wires == &m.stream_wire);
 
-  // Flattern graphs ------------------------------------------------------------------------------   
-  for(auto &inst: m.instances){
-    if(subgraphs.find(inst.first) != subgraphs.end()){
-      // This is a module's graph
-      auto& inst_g {subgraphs.at(inst.first)};
-      for(auto &[k, v]: inst_g.vertices){
-        auto new_v = v;
-        new_v.edges.clear();
-        for(const auto&e : v.edges){
-          if(inst_g.pi.find(e) == inst_g.pi.end() and 
-            inst_g.po.find(e) == inst_g.po.end() and 
-            g.pi.find(e) == g.pi.end() and 
-            g.po.find(e) == g.po.end() ){
-            new_v.edges.insert(inst.first+_divider+e);
-          }
-          else{
-            new_v.edges.insert(e);
-          }
-        }
-        g.vertices.insert({inst.first+_divider+k, std::move(new_v)});
+      if(insts.first != EMPTY_SYMBOL){
+        e.from = endpoint(insts.first, wire_name);
       }
-      for(auto &[k, e]: inst_g.edges){
-        // Update the vertices in edge 
-        e.from.insert(0, 1, _divider);
-        e.to.insert(0, 1, _divider);
-        e.from.insert(0, inst.first);
-        e.to.insert(0, inst.first);
-        g.edges.insert({inst.first+_divider+k, std::move(e)});
+      if(insts.second != EMPTY_SYMBOL){
+        e.to = endpoint(insts.second, wire_name);
       }
     }
   }
+}
+
+
+// Function: flatten
+// Expand the hierarchy below a module into a graph of leaf cells named by
+// their instance paths. The flat graph is built on demand; module graphs are
+// only read.
+inline Des::Graph Des::flatten(Symbol module_name) const {
+  const auto& g {_graphs.at(module_name)};
+
+  Graph flat;
+  flat.pi = g.pi;
+  flat.po = g.po;
 
+  _flatten(g, ROOT_PATH, flat);
 
+  // Attach the ports and edges to their vertices
+  auto attach = [&](Path v, Path e){
+    if(auto itr = flat.vertices.find(v); itr != flat.vertices.end()){
+      itr->second.edges.insert(e);
+    }
+  };
 
-  std::cout << "\n\nGraph Info " << module_name << " : \n";
-  for(const auto& [k, v]: g.pi){
-    std::cout << "PI : " << k << " / " << v << '\n';
+  for(const auto& [port, v]: flat.pi){
+    attach(v, path_of(port));
   }
-  for(const auto& [k, v]: g.po){
-    std::cout << "PI : " << k << " / " << v << '\n';
+  for(const auto& [port, v]: flat.po){
+    attach(v, path_of(port));
   }
-  for(const auto& [k, v]: g.vertices){
-    std::cout << "Vertex = " << k << '\n';
+  for(const auto& [name, e]: flat.edges){
+    attach(e.from, name);
+    attach(e.to, name);
   }
-  for(const auto& [k, e]: g.edges){
-    std::cout << "Edge = " << k << "  from: " << e.from << " to: " << e.to << '\n';
+
+  return flat;
+}
+
+
+// Procedure: _flatten
+// Copy the vertices and edges of a module graph under the given prefix and 
+// recurse into its children.
+inline void Des::_flatten(const Graph& g, Path prefix, Graph& flat) const {
+  for(const auto& [name, v]: g.vertices){
+    flat.vertices[_join(prefix, name)].module_name = v.module_name;
+  }
+
+  for(const auto& [name, e]: g.edges){
+    auto& fe {flat.edges[_join(prefix, name)]};
+    fe.name = _join(prefix, e.name);
+    fe.from = _join(prefix, e.from);
+    fe.to = _join(prefix, e.to);
+    fe.stream = e.stream;
   }
-  std::cout << "\n-------------------------------\n\n";
 
+  for(const auto& [name, child]: g.children){
+    _flatten(*child.graph, PathTable::get().child(prefix, name), flat);
+  }
 }
+
+
 };  // end of namespace sda. ----------------------------------------------------------------------
 
 #endif
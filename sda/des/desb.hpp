@@ -0,0 +1,384 @@
+#ifndef SDA_DES_DESB_HPP_
+#define SDA_DES_DESB_HPP_
+
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include <sda/utility/mmap.hpp>
+#include <sda/utility/path.hpp>
+
+namespace sda::des {
+
+// A .desb file caches parsed modules and built graphs so an unchanged flow
+// does not have to be lexed again. Layout (little-endian):
+//
+//   DesbHeader
+//   body    : uint32_t[num_words]              records written by Des
+//   paths   : uint32_t[2 * num_paths]          (parent path, leaf string)
+//   offsets : uint32_t[num_strings + 1]        into the character pool
+//   pool    : char[]                           string characters
+//
+// Names in the body are indices into the string or path table, and source
+// file paths are pool strings as well. A reader interns each pool string at
+// most once, straight from the mapped file, and never allocates per field.
+// String 0 is the empty name and path 0 is the root.
+inline constexpr char DESB_MAGIC[4] {'D', 'E', 'S', 'B'};
+inline constexpr uint32_t DESB_VERSION {3};
+
+// Struct: DesbHeader
+struct DesbHeader {
+  char magic[4];
+  uint32_t version;
+  uint32_t num_words;
+  uint32_t num_paths;
+  uint32_t num_strings;
+  uint32_t pool_size;
+};
+
+// Class: DesbWriter
+// Accumulate the body and the string/path tables of a .desb file.
+class DesbWriter {
+
+  public:
+
+    DesbWriter();
+
+    void word(uint32_t);
+    void word64(uint64_t);
+    void string(std::string_view);
+    void symbol(Symbol);
+    void path(Path);
+
+    template <typename C>
+    void symbols(const C&);
+
+    bool write(const std::filesystem::path&) const;
+
+  private:
+
+    std::vector<uint32_t> _body;
+    std::vector<uint32_t> _paths;
+    std::vector<uint32_t> _offsets;
+    std::string _pool;
+
+    std::unordered_map<Symbol, uint32_t> _symbol_ids;
+    std::unordered_map<Path, uint32_t> _path_ids;
+
+    uint32_t _symbol(Symbol);
+    uint32_t _path(Path);
+};
+
+// Constructor
+inline DesbWriter::DesbWriter() {
+  _offsets.push_back(0);
+  _symbol(EMPTY_SYMBOL);
+  _paths.insert(_paths.end(), {0, 0});
+  _path_ids.emplace(ROOT_PATH, 0);
+}
+
+// Procedure: word
+inline void DesbWriter::word(uint32_t w) {
+  _body.push_back(w);
+}
+
+// Procedure: word64
+inline void DesbWriter::word64(uint64_t w) {
+  _body.push_back(static_cast<uint32_t>(w));
+  _body.push_back(static_cast<uint32_t>(w >> 32));
+}
+
+// Procedure: string
+// Write a string that is not a name, e.g., a file path. It is not shared.
+inline void DesbWriter::string(std::string_view s) {
+  _body.push_back(static_cast<uint32_t>(_offsets.size() - 1));
+  _pool.append(s);
+  _offsets.push_back(static_cast<uint32_t>(_pool.size()));
+}
+
+// Procedure: symbol
+inline void DesbWriter::symbol(Symbol s) {
+  _body.push_back(_symbol(s));
+}
+
+// Procedure: path
+inline void DesbWriter::path(Path p) {
+  _body.push_back(_path(p));
+}
+
+// Procedure: symbols
+// Write a count followed by the symbols of a container.
+template <typename C>
+void DesbWriter::symbols(const C& c) {
+  word(static_cast<uint32_t>(c.size()));
+  for(const auto s : c) {
+    symbol(s);
+  }
+}
+
+// Function: _symbol
+inline uint32_t DesbWriter::_symbol(Symbol s) {
+  auto [itr, inserted] = _symbol_ids.try_emplace(s, static_cast<uint32_t>(_offsets.size() - 1));
+  if(inserted) {
+    _pool.append(name_of(s));
+    _offsets.push_back(static_cast<uint32_t>(_pool.size()));
+  }
+  return itr->second;
+}
+
+// Function: _path
+// Parents are always recorded before their children.
+inline uint32_t DesbWriter::_path(Path p) {
+  if(auto itr = _path_ids.find(p); itr != _path_ids.end()) {
+    return itr->second;
+  }
+  const auto& paths = PathTable::get();
+  const auto parent = _path(paths.parent(p));
+  const auto leaf = _symbol(paths.leaf(p));
+  const auto id = static_cast<uint32_t>(_paths.size() / 2);
+  _paths.insert(_paths.end(), {parent, leaf});
+  _path_ids.emplace(p, id);
+  return id;
+}
+
+// Function: write
+// Write the file next to its destination and rename it in place, so readers
+// never see a partial cache.
+inline bool DesbWriter::write(const std::filesystem::path& p) const {
+
+  DesbHeader header;
+  std::memcpy(header.magic, DESB_MAGIC, sizeof(header.magic));
+  header.version = DESB_VERSION;
+  header.num_words = static_cast<uint32_t>(_body.size());
+  header.num_paths = static_cast<uint32_t>(_paths.size() / 2);
+  header.num_strings = static_cast<uint32_t>(_offsets.size() - 1);
+  header.pool_size = static_cast<uint32_t>(_pool.size());
+
+  const auto tmp = p.string() + ".tmp";
+
+  {
+    std::ofstream ofs(tmp, std::ios::binary | std::ios::trunc);
+
+    auto put = [&] (const void* data, size_t size) {
+      ofs.write(static_cast<const char*>(data), size);
+    };
+
+    put(&header, sizeof(header));
+    put(_body.data(), _body.size() * sizeof(uint32_t));
+    put(_paths.data(), _paths.size() * sizeof(uint32_t));
+    put(_offsets.data(), _offsets.size() * sizeof(uint32_t));
+    put(_pool.data(), _pool.size());
+
+    if(!ofs.flush()) {
+      std::remove(tmp.c_str());
+      return false;
+    }
+  }
+
+  return std::rename(tmp.c_str(), p.c_str()) == 0;
+}
+
+// ------------------------------------------------------------------------------------------------
+
+// Class: DesbReader
+// Map a .desb file and read its body word by word. Strings and paths are
+// interned lazily, the first time they are referenced, straight from the
+// mapped pool. Reads past the end or indices out of range clear good() and
+// return zero, so a truncated or corrupt cache is rejected instead of 
+// trusted.
+class DesbReader {
+
+  static constexpr uint32_t UNSET {std::numeric_limits<uint32_t>::max()};
+
+  public:
+
+    bool open(const std::filesystem::path&);
+
+    bool good() const;
+    bool eof() const;
+
+    size_t remaining() const;
+
+    uint32_t word();
+    uint32_t count();
+    uint64_t word64();
+    std::string_view string();
+    Symbol symbol();
+    Path path();
+
+  private:
+
+    MappedFile _file;
+
+    const uint32_t* _body {nullptr};
+    const uint32_t* _paths_table {nullptr};
+    const uint32_t* _offsets {nullptr};
+    const char* _pool {nullptr};
+
+    size_t _num_words {0};
+    size_t _cursor {0};
+    bool _good {false};
+
+    std::vector<Symbol> _symbols;
+    std::vector<Path> _paths;
+
+    Symbol _symbol(uint32_t);
+    Path _path(uint32_t);
+};
+
+// Function: open
+// Validate the header and the string and path tables.
+inline bool DesbReader::open(const std::filesystem::path& p) {
+
+  _good = false;
+
+  if(!_file.open(p) || !_file.is_mapped() || _file.size() < sizeof(DesbHeader)) {
+    return false;
+  }
+
+  DesbHeader header;
+  std::memcpy(&header, _file.data(), sizeof(header));
+
+  if(std::memcmp(header.magic, DESB_MAGIC, sizeof(header.magic)) != 0 ||
+     header.version != DESB_VERSION || header.num_paths == 0 || header.num_strings == 0) {
+    return false;
+  }
+
+  const size_t expected = sizeof(DesbHeader) +
+    (size_t{header.num_words} + 2 * size_t{header.num_paths} + header.num_strings + 1) * sizeof(uint32_t) +
+    header.pool_size;
+
+  if(_file.size() != expected) {
+    return false;
+  }
+
+  _body = reinterpret_cast<const uint32_t*>(_file.data() + sizeof(DesbHeader));
+  _paths_table = _body + header.num_words;
+  _offsets = _paths_table + 2 * size_t{header.num_paths};
+  _pool = reinterpret_cast<const char*>(_offsets + header.num_strings + 1);
+  _num_words = header.num_words;
+  _cursor = 0;
+
+  for(size_t i=0; i<header.num_strings; ++i) {
+    if(_offsets[i] > _offsets[i+1] || _offsets[i+1] > header.pool_size) {
+      return false;
+    }
+  }
+
+  // Parents precede their children, which bounds the recursion in _path
+  for(size_t i=1; i<header.num_paths; ++i) {
+    if(_paths_table[2*i] >= i || _paths_table[2*i + 1] >= header.num_strings) {
+      return false;
+    }
+  }
+
+  _symbols.assign(header.num_strings, UNSET);
+  _paths.assign(header.num_paths, UNSET);
+  _paths[0] = ROOT_PATH;
+
+  _good = true;
+
+  return true;
+}
+
+// Function: good
+inline bool DesbReader::good() const {
+  return _good;
+}
+
+// Function: eof
+inline bool DesbReader::eof() const {
+  return _cursor == _num_words;
+}
+
+// Function: remaining
+inline size_t DesbReader::remaining() const {
+  return _num_words - _cursor;
+}
+
+// Function: word
+inline uint32_t DesbReader::word() {
+  if(!_good || _cursor == _num_words) {
+    _good = false;
+    return 0;
+  }
+  return _body[_cursor++];
+}
+
+// Function: count
+// Read the number of the items that follow. Every item takes at least one
+// word, so a count over the words left comes from a corrupt file and fails
+// the reader rather than sizing a container.
+inline uint32_t DesbReader::count() {
+  const auto n = word();
+  if(n > remaining()) {
+    _good = false;
+    return 0;
+  }
+  return n;
+}
+
+// Function: word64
+inline uint64_t DesbReader::word64() {
+  const uint64_t lo = word();
+  const uint64_t hi = word();
+  return lo | (hi << 32);
+}
+
+// Function: string
+// Return a pool string without interning it. The view lives as long as the
+// reader.
+inline std::string_view DesbReader::string() {
+  const auto i = word();
+  if(i >= _symbols.size()) {
+    _good = false;
+    return {};
+  }
+  return {_pool + _offsets[i], _offsets[i+1] - _offsets[i]};
+}
+
+// Function: symbol
+inline Symbol DesbReader::symbol() {
+  const auto i = word();
+  if(i >= _symbols.size()) {
+    _good = false;
+    return EMPTY_SYMBOL;
+  }
+  return _symbol(i);
+}
+
+// Function: path
+inline Path DesbReader::path() {
+  const auto i = word();
+  if(i >= _paths.size()) {
+    _good = false;
+    return ROOT_PATH;
+  }
+  return _path(i);
+}
+
+// Function: _symbol
+inline Symbol DesbReader::_symbol(uint32_t i) {
+  if(_symbols[i] == UNSET) {
+    _symbols[i] = intern(std::string_view(_pool + _offsets[i], _offsets[i+1] - _offsets[i]));
+  }
+  return _symbols[i];
+}
+
+// Function: _path
+inline Path DesbReader::_path(uint32_t i) {
+  if(_paths[i] == UNSET) {
+    _paths[i] = PathTable::get().child(_path(_paths_table[2*i]), _symbol(_paths_table[2*i + 1]));
+  }
+  return _paths[i];
+}
+
+
+};  // end of namespace sda::des. -----------------------------------------------------------------
+
+#endif
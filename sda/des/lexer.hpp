@@ -0,0 +1,232 @@
+#ifndef SDA_DES_LEXER_HPP_
+#define SDA_DES_LEXER_HPP_
+
+#include <array>
+#include <cstdint>
+#include <string_view>
+
+namespace sda::des {
+
+// Enum: Keyword
+// Words that begin a statement.
+enum class Keyword : uint8_t {
+  NONE = 0,
+  MODULE,
+  INPUT,
+  OUTPUT,
+  WIRE,
+  ENDMODULE
+};
+
+namespace keyword_detail {
+
+struct Entry {
+  std::string_view name;
+  Keyword keyword;
+};
+
+// The keywords; entry 0 marks an empty slot. A new keyword only needs an
+// entry here, the hash below is searched again at compile time.
+inline constexpr Entry entries[] = {
+  {"",          Keyword::NONE},
+  {"module",    Keyword::MODULE},
+  {"input",     Keyword::INPUT},
+  {"output",    Keyword::OUTPUT},
+  {"wire",      Keyword::WIRE},
+  {"endmodule", Keyword::ENDMODULE}
+};
+
+inline constexpr size_t num_entries {sizeof(entries) / sizeof(Entry)};
+
+// Table size, a power of two with at least twice as many slots as keywords
+inline constexpr size_t num_bits {num_entries <= 8 ? 4 : num_entries <= 32 ? 6 : 8};
+inline constexpr size_t num_slots {size_t{1} << num_bits};
+
+inline constexpr size_t max_size {[] () {
+  size_t n {0};
+  for(const auto& e : entries) {
+    n = e.name.size() > n ? e.name.size() : n;
+  }
+  return n;
+}()};
+
+// Function: hash
+// Multiplicative hash of the length and the first and last characters of a
+// nonempty word, taking the top bits of the product.
+constexpr size_t hash(std::string_view w, uint32_t seed) {
+  const uint32_t key = static_cast<uint8_t>(w.front()) |
+                       static_cast<uint32_t>(static_cast<uint8_t>(w.back())) << 8 |
+                       static_cast<uint32_t>(w.size()) << 16;
+  return static_cast<uint32_t>(key * seed) >> (32 - num_bits);
+}
+
+// Function: find_seed
+// Find the first odd seed for which no two keywords share a slot, or 0.
+constexpr uint32_t find_seed() {
+  for(uint32_t seed = 1; seed < (1u << 16); seed += 2) {
+    bool used[num_slots] {};
+    bool perfect {true};
+    for(size_t i=1; i<num_entries && perfect; ++i) {
+      auto& slot = used[hash(entries[i].name, seed)];
+      perfect = !slot;
+      slot = true;
+    }
+    if(perfect) {
+      return seed;
+    }
+  }
+  return 0;
+}
+
+inline constexpr uint32_t seed {find_seed()};
+
+static_assert(seed != 0, "no perfect hash for the keywords; widen the table");
+
+// slot -> entry index
+inline constexpr std::array<uint8_t, num_slots> slots {[] () {
+  std::array<uint8_t, num_slots> t {};
+  for(size_t i=1; i<num_entries; ++i) {
+    t[hash(entries[i].name, seed)] = static_cast<uint8_t>(i);
+  }
+  return t;
+}()};
+
+};  // end of namespace keyword_detail. -----------------------------------------------------------
+
+// Function: find_keyword
+// Return the keyword spelled exactly by a word, or NONE, with one hash and
+// at most one comparison.
+constexpr Keyword find_keyword(std::string_view w) {
+  using namespace keyword_detail;
+  if(w.empty() || w.size() > max_size) {
+    return Keyword::NONE;
+  }
+  const auto& e = entries[slots[hash(w, seed)]];
+  return e.name == w ? e.keyword : Keyword::NONE;
+}
+
+// ------------------------------------------------------------------------------------------------
+
+// Struct: Token
+// A keyword token also carries which keyword it is.
+struct Token {
+
+  enum class Type : uint8_t {
+    END = 0,
+    IDENTIFIER,
+    KEYWORD,
+    LPAREN,
+    RPAREN,
+    DOT,
+    COMMA,
+    SEMICOLON
+  };
+
+  Type type {Type::END};
+  std::string_view text;
+  Keyword keyword {Keyword::NONE};
+
+  bool is(Type t) const { return type == t; }
+  bool is(Type t, std::string_view s) const { return type == t and text == s; }
+};
+
+// ------------------------------------------------------------------------------------------------
+
+// Class: Lexer
+// Single-pass lexer over a statement of the des language. Every byte is
+// classified through a 256-entry table and visited once. An identifier is a
+// maximal run of bytes that are neither whitespace nor punctuation; whether
+// it is a legal name is left to the caller. Token texts are views into the
+// input buffer.
+class Lexer {
+
+  public:
+
+    Lexer(std::string_view);
+
+    Token next();
+
+    size_t position() const;
+
+  private:
+
+    enum Class : uint8_t {
+      WORD = 0,
+      SPACE,
+      PUNCT
+    };
+
+    static constexpr std::array<uint8_t, 256> _classes();
+
+    static const std::array<uint8_t, 256> _table;
+
+    std::string_view _buf;
+
+    size_t _pos {0};
+};
+
+// Constructor
+inline Lexer::Lexer(std::string_view buf) : _buf {buf} {
+}
+
+// Function: _classes
+inline constexpr std::array<uint8_t, 256> Lexer::_classes() {
+  std::array<uint8_t, 256> t {};
+  for(unsigned char c : std::string_view(" \t\n\r\v\f")) {
+    t[c] = SPACE;
+  }
+  for(unsigned char c : std::string_view("().,;")) {
+    t[c] = PUNCT;
+  }
+  return t;
+}
+
+// Byte classes
+inline const std::array<uint8_t, 256> Lexer::_table {Lexer::_classes()};
+
+// Function: position
+// Offset of the next byte to read.
+inline size_t Lexer::position() const {
+  return _pos;
+}
+
+// Function: next
+inline Token Lexer::next() {
+
+  while(_pos < _buf.size() and _table[static_cast<uint8_t>(_buf[_pos])] == SPACE) {
+    ++_pos;
+  }
+
+  if(_pos == _buf.size()) {
+    return {Token::Type::END, {}};
+  }
+
+  const size_t beg {_pos++};
+
+  switch(_buf[beg]) {
+    case '(': return {Token::Type::LPAREN,    _buf.substr(beg, 1)};
+    case ')': return {Token::Type::RPAREN,    _buf.substr(beg, 1)};
+    case '.': return {Token::Type::DOT,       _buf.substr(beg, 1)};
+    case ',': return {Token::Type::COMMA,     _buf.substr(beg, 1)};
+    case ';': return {Token::Type::SEMICOLON, _buf.substr(beg, 1)};
+    default:  break;
+  }
+
+  while(_pos < _buf.size() and _table[static_cast<uint8_t>(_buf[_pos])] == WORD) {
+    ++_pos;
+  }
+
+  const auto word {_buf.substr(beg, _pos-beg)};
+
+  // Statement keywords; the word is maximal, so "wire_buf" is no keyword
+  if(const auto keyword {find_keyword(word)}; keyword != Keyword::NONE) {
+    return {Token::Type::KEYWORD, word, keyword};
+  }
+
+  return {Token::Type::IDENTIFIER, word};
+}
+
+
+};  // end of namespace sda::des. -----------------------------------------------------------------
+
+#endif
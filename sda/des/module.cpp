@@ -1,171 +1,759 @@
-#include <ot/verilog/verilog.hpp>
+#include <sda/des/module.hpp>
+#include <sda/utility/mmap.hpp>
+#include <sda/utility/threadpool.hpp>
+#include <sda/utility/tokenizer.hpp>
+#include <sda/utility/writer.hpp>
+#include <charconv>
+#include <cstdlib>
+#include <iostream>
 
-namespace ot::des {
+namespace sda::des {
 
-// Operator <<
-std::ostream& operator << (std::ostream& os, const Gate& inst) {
-  os << inst.cell << ' ' << inst.name << " ( ";
-  size_t i {0};
-  for(const auto& [pin, net] : inst.cellpin2net) {
-    if(i++ != 0) {
-      os << ", ";
+// Function: num_gates
+size_t Netlist::num_gates() const {
+  return gate_cells.size();
+}
+
+// Function: num_pins
+size_t Netlist::num_pins() const {
+  return pin_names.size();
+}
+
+// Function: memory
+// Return the bytes held by the netlist.
+size_t Netlist::memory() const {
+  size_t bytes = sizeof(Netlist) + name.capacity() +
+                 nets.memory() + buses.memory() + gates.memory() +
+                 declarations.capacity() * sizeof(Declaration) +
+                 gate_cells.capacity() * sizeof(Symbol) +
+                 pin_offsets.capacity() * sizeof(uint64_t) +
+                 pin_names.capacity() * sizeof(Symbol) +
+                 pin_nets.capacity() * sizeof(uint32_t);
+  for(const auto& port : ports) {
+    bytes += sizeof(port) + port.capacity();
+  }
+  return bytes;
+}
+
+// Function: info
+std::string Netlist::info() const {
+  size_t num_inputs {0}, num_outputs {0};
+  for(const auto& d : declarations) {
+    const size_t bits = d.bus ? std::abs(d.msb - d.lsb) + 1 : 1;
+    num_inputs += (d.direction == Direction::INPUT) * bits;
+    num_outputs += (d.direction == Direction::OUTPUT) * bits;
+  }
+  return "verilog module \"" + name + "\" " +
+         "[inputs:" + std::to_string(num_inputs) +
+         "|outputs:" + std::to_string(num_outputs) +
+         "|nets:" + std::to_string(nets.size()) +
+         "|gates:" + std::to_string(num_gates()) + "]";
+}
+
+namespace {
+
+// Procedure: write_name
+// An escaped name, e.g., "\n1[0]", ends at whitespace, so a space follows it.
+template <typename O>
+void write_name(O& os, std::string_view name) {
+  os << name;
+  if(!name.empty() && name[0] == '\\') {
+    os << ' ';
+  }
+}
+
+// Procedure: write_header
+// Write the module header and the declarations.
+template <typename O>
+void write_header(O& os, const Netlist& n) {
+
+  static constexpr std::string_view keywords[] = {"input", "output", "inout", "wire"};
+
+  os << "module " << n.name << " (";
+  for(size_t i=0; i<n.ports.size(); ++i) {
+    os << (i ? ", " : "");
+    write_name(os, n.ports[i]);
+  }
+  os << ");\n";
+
+  for(const auto& d : n.declarations) {
+    os << keywords[static_cast<size_t>(d.direction)] << ' ';
+    if(d.bus) {
+      os << '[' << d.msb << ':' << d.lsb << "] ";
+      write_name(os, n.buses[d.name]);
     }
-    os << '.' << pin << '(' << net << ')';
+    else {
+      write_name(os, n.nets[d.name]);
+    }
+    os << ";\n";
   }
-  os << " );";
-  return os;
 }
 
-// ------------------------------------------------------------------------------------------------
+// Procedure: write_gates
+// Write the gates [beg, end) in id order. The few cell and pin names are
+// looked up once rather than through the locked symbol table on every use.
+template <typename O>
+void write_gates(O& os, const Netlist& n, size_t beg, size_t end) {
 
-// Operator: <<
-std::ostream& operator << (std::ostream& os, const Module& m) {
+  std::vector<std::string_view> names;
 
-  os << "module " << m.name << " (\n";  
+  auto name = [&] (Symbol s) {
+    if(s >= names.size()) {
+      names.resize(s + 1);
+    }
+    if(names[s].data() == nullptr) {
+      names[s] = name_of(s);
+    }
+    return names[s];
+  };
 
-  for(size_t i=0; i<m.ports.size(); ++i) {
-    os << m.ports[i];
-    if(i != m.ports.size() - 1) {
-      os << ",\n";
+  for(size_t g=beg; g<end; ++g) {
+    os << name(n.gate_cells[g]) << ' ' << n.gates[g] << " (";
+    for(auto p=n.pin_offsets[g]; p<n.pin_offsets[g+1]; ++p) {
+      os << (p == n.pin_offsets[g] ? " ." : ", .");
+      write_name(os, name(n.pin_names[p]));
+      os << '(';
+      if(n.pin_nets[p] != Netlist::NONE) {
+        write_name(os, n.nets[n.pin_nets[p]]);
+      }
+      os << ')';
     }
+    os << " );\n";
   }
-  os << ");\n\n";
+}
+
+};  // end of anonymous namespace. ----------------------------------------------------------------
 
-  os << "// Start PIs\n";
-  for(const auto& pi : m.inputs) {
-    os << "input " << pi << ";\n";
+// Operator: <<
+// The text is formatted in blocks of gates rather than token by token
+// through the stream.
+std::ostream& operator << (std::ostream& os, const Netlist& n) {
+
+  constexpr size_t block {1 << 12};
+
+  WriteBuffer buffer;
+
+  write_header(buffer, n);
+
+  for(size_t g=0; g<n.num_gates(); g+=block) {
+    write_gates(buffer, n, g, std::min(g + block, n.num_gates()));
+    os.write(buffer.data(), buffer.size());
+    buffer.clear();
   }
-  os << '\n';
-  
-  os << "// Start POs\n";
-  for(const auto& po : m.outputs) {
-    os << "output " << po << ";\n";
+
+  buffer << "endmodule\n";
+  os.write(buffer.data(), buffer.size());
+
+  return os;
+}
+
+// Function: write_verilog
+// Write the netlist to a file, or to the standard output on path "-". Gates
+// are written in id order, i.e., the order in which they were read, so the
+// output is deterministic and diffable. With several threads, consecutive
+// shards of gates are formatted in parallel into reusable buffers and
+// written in order with writev. Errors are reported on std::cerr.
+bool write_verilog(const std::filesystem::path& path, const Netlist& n, unsigned num_threads) {
+
+  // Gates per shard
+  constexpr size_t shard {1 << 16};
+
+  Writer writer(path);
+
+  if(!writer.good()) {
+    std::cerr << "failed to open " << path << '\n';
+    return false;
   }
-  os << '\n';
-  
-  os << "// Start wires\n"; 
-  for(const auto& wire : m.wires) {
-    os << "wire " << wire << ";\n";
+
+  write_header(writer, n);
+
+  const size_t num_gates = n.num_gates();
+
+  if(num_threads <= 1 || num_gates < 2 * shard) {
+    write_gates(writer, n, 0, num_gates);
+  }
+  else {
+
+    std::vector<WriteBuffer> buffers(num_threads);
+
+    // The calling thread takes part in every round
+    Threadpool pool(num_threads - 1);
+
+    // Format one round of a shard per buffer, then write the round out
+    for(size_t beg=0; beg<num_gates && writer.good(); beg+=num_threads*shard) {
+
+      pool.parallel_for(num_threads, [&] (size_t i) {
+        buffers[i].clear();
+        const size_t b = std::min(beg + i * shard, num_gates);
+        write_gates(buffers[i], n, b, std::min(b + shard, num_gates));
+      });
+
+      writer.write(buffers);
+    }
   }
-  os << '\n';
 
-  os << "// Start cells\n";
-  for(const auto& gate : m.gates) {
-    os << gate << '\n';
+  writer << "endmodule\n";
+
+  if(!writer.close()) {
+    std::cerr << "failed to write " << path << '\n';
+    return false;
   }
-  os << '\n';
 
-  os << "endmodule";
-  
-  return os;
+  return true;
 }
 
 // ------------------------------------------------------------------------------------------------
 
-// Function: info
-std::string Module::info() const {
-  return "verilog module \""s + name + "\" " +
-         "[inputs:" + std::to_string(inputs.size()) +
-         "|outputs:" + std::to_string(outputs.size()) +
-         "|gates:" + std::to_string(gates.size()) + "]";
+namespace {
+
+// Every delimiter is kept as a one-character token
+constexpr std::string_view delimiters {"(),;[]:.={}"};
+
+// Class: StatementReader
+// Read the statements of a token range into a netlist, appending to it. The
+// range may be a single-pass TokenStream, so a token is used before the
+// reader advances past it. Errors are recorded rather than printed, because
+// the reader of a speculative chunk may be discarded.
+template <typename I>
+class StatementReader {
+
+  using Direction = Netlist::Direction;
+
+  public:
+
+    StatementReader(I, I, Netlist&, bool);
+
+    bool read();
+
+    bool closed() const { return _closed; }
+
+    const std::string& error() const { return _error; }
+
+  private:
+
+    I _itr;
+    I _end;
+
+    Netlist& _netlist;
+
+    bool _in_module {false};
+    bool _closed {false};
+
+    std::string _error;
+    std::string _name;
+
+    bool _done() const { return _itr == _end; }
+    std::string_view _token() const { return _done() ? std::string_view() : *_itr; }
+    void _advance() { if(!_done()) ++_itr; }
+
+    bool _accept(std::string_view);
+    bool _expect(std::string_view);
+    bool _fail(std::string_view);
+
+    bool _identifier(std::string&);
+    bool _integer(int32_t&);
+    bool _range(int32_t&, int32_t&);
+    bool _direction(std::string_view, Direction&) const;
+
+    bool _module();
+    bool _declaration(Direction);
+    bool _declare(Direction, bool, int32_t, int32_t);
+    bool _gate();
+    bool _net(uint32_t&);
+};
+
+// Constructor
+template <typename I>
+StatementReader<I>::StatementReader(I beg, I end, Netlist& netlist, bool in_module) :
+  _itr       {beg},
+  _end       {end},
+  _netlist   {netlist},
+  _in_module {in_module} {
+}
+
+// Function: _accept
+template <typename I>
+bool StatementReader<I>::_accept(std::string_view t) {
+  if(!_done() && *_itr == t) {
+    ++_itr;
+    return true;
+  }
+  return false;
+}
+
+// Function: _expect
+template <typename I>
+bool StatementReader<I>::_expect(std::string_view t) {
+  return _accept(t) || _fail(std::string("expected '").append(t).append("'"));
+}
+
+// Function: _fail
+template <typename I>
+bool StatementReader<I>::_fail(std::string_view what) {
+  if(_error.empty()) {
+    _error.append(what);
+    if(_done()) {
+      _error.append(" at end of input");
+    }
+    else {
+      _error.append(" near '").append(_token()).append("'");
+    }
+  }
+  return false;
 }
 
-// Procedure: read_verilog
-Module read_verilog(const std::filesystem::path& path) {
+// Function: _identifier
+// Copy a name token into s and advance past it.
+template <typename I>
+bool StatementReader<I>::_identifier(std::string& s) {
+  const auto t = _token();
+  if(t.empty() || (t.size() == 1 && delimiters.find(t[0]) != std::string_view::npos)) {
+    return _fail("expected a name");
+  }
+  s.assign(t);
+  _advance();
+  return true;
+}
 
-  Module module;
-  
-  static std::string_view delimiters = "(),:;/#[]{}*\"\\";
-  static std::string_view exceptions = "().";
-  
-  auto tokens = tokenize(path, delimiters, exceptions);
+// Function: _integer
+template <typename I>
+bool StatementReader<I>::_integer(int32_t& v) {
+  const auto t = _token();
+  if(auto [p, ec] = std::from_chars(t.data(), t.data() + t.size(), v);
+     t.empty() || ec != std::errc() || p != t.data() + t.size()) {
+    return _fail("expected an integer");
+  }
+  _advance();
+  return true;
+}
 
-  // Set up the iterator
-  auto itr = tokens.begin();
-  auto end = tokens.end();
+// Function: _range
+// [msb:lsb]
+template <typename I>
+bool StatementReader<I>::_range(int32_t& msb, int32_t& lsb) {
+  return _expect("[") && _integer(msb) && _expect(":") && _integer(lsb) && _expect("]");
+}
 
-  // Read the module name
-  if(itr = std::find(itr, end, "module"); itr == end) {
-    OT_LOGF("can't find keyword 'module'");
+// Function: _direction
+template <typename I>
+bool StatementReader<I>::_direction(std::string_view t, Direction& d) const {
+  if(t == "input") {
+    d = Direction::INPUT;
+  }
+  else if(t == "output") {
+    d = Direction::OUTPUT;
+  }
+  else if(t == "inout") {
+    d = Direction::INOUT;
+  }
+  else if(t == "wire" || t == "tri" || t == "supply0" || t == "supply1") {
+    d = Direction::WIRE;
   }
   else {
-    if(++itr == end) {
-      OT_LOGF("syntax error in module name");
-    }
-    module.name = std::move(*itr);
-  }
-
-  // Read the ports
-  if(itr = on_next_parentheses(
-    itr, 
-    end, 
-    [&] (auto& str) mutable { module.ports.push_back(std::move(str)); }); itr == end) {
-    OT_LOGF("syntax error in module ports");
-  }
-  
-  // Parse the content.
-  while(++itr != end) {
-    
-    if(*itr == "input") {
-      if(++itr == end) {
-        OT_LOGF("syntax error in input");
+    return false;
+  }
+  return true;
+}
+
+// Function: read
+// Read statements until "endmodule" or the end of the range. Anything before
+// the module, e.g., compiler directives, is skipped.
+template <typename I>
+bool StatementReader<I>::read() {
+
+  while(!_done()) {
+
+    const auto t = _token();
+
+    if(!_in_module) {
+      if(_accept("module")) {
+        if(!_module()) {
+          return false;
+        }
+      }
+      else {
+        _advance();
       }
-      module.inputs.push_back(std::move(*itr));
     }
-    else if(*itr == "output") {
-      if(++itr == end) {
-        OT_LOGF("syntax error in output");
+    else if(Direction d; _direction(t, d)) {
+      _advance();
+      if(!_declaration(d)) {
+        return false;
       }
-      module.outputs.push_back(std::move(*itr));
     }
-    else if(*itr == "wire") {
-      if(++itr == end) {
-        OT_LOGF("syntax error in wire");
+    else if(t == "module") {
+      return _fail("nested module");
+    }
+    else if(t == "endmodule") {
+      _advance();
+      _closed = true;
+      return true;
+    }
+    else if(t == "assign") {
+      return _fail("unsupported statement");
+    }
+    else if(!_gate()) {
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// Function: _module
+// module name (a, b, ...); or module name (input a, output [3:0] b, ...);
+template <typename I>
+bool StatementReader<I>::_module() {
+
+  if(!_identifier(_netlist.name) || !_expect("(")) {
+    return false;
+  }
+
+  std::optional<Direction> direction;
+  int32_t msb {0}, lsb {0};
+  bool bus {false};
+
+  while(!_accept(")")) {
+    if(!_netlist.ports.empty() && !_expect(",")) {
+      return false;
+    }
+    if(Direction d; _direction(_token(), d)) {
+      _advance();
+      direction = d;
+      if(d != Direction::WIRE) {
+        _accept("wire");
+      }
+      if((bus = (_token() == "[")) && !_range(msb, lsb)) {
+        return false;
       }
-      module.wires.push_back(std::move(*itr));
     }
-    else if(*itr == "endmodule") {
+    if(!_identifier(_name)) {
+      return false;
+    }
+    _netlist.ports.push_back(_name);
+    if(direction && !_declare(*direction, bus, msb, lsb)) {
+      return false;
+    }
+  }
+
+  _in_module = true;
+
+  return _expect(";");
+}
+
+// Function: _declaration
+// input [msb:lsb] a, b, ...;
+template <typename I>
+bool StatementReader<I>::_declaration(Direction d) {
+
+  int32_t msb {0}, lsb {0};
+
+  if(d != Direction::WIRE) {
+    _accept("wire");
+  }
+
+  const bool bus = (_token() == "[");
+
+  if(bus && !_range(msb, lsb)) {
+    return false;
+  }
+
+  do {
+    if(!_identifier(_name) || !_declare(d, bus, msb, lsb)) {
+      return false;
+    }
+  } while(_accept(","));
+
+  return _expect(";");
+}
+
+// Function: _declare
+// Declare _name, and the nets of its bits if it is a bus.
+template <typename I>
+bool StatementReader<I>::_declare(Direction d, bool bus, int32_t msb, int32_t lsb) {
+
+  auto& n = _netlist;
+
+  if(!bus) {
+    n.declarations.push_back({d, false, n.nets.insert(_name), 0, 0});
+    return true;
+  }
+
+  n.declarations.push_back({d, true, n.buses.insert(_name), msb, lsb});
+
+  const auto size = _name.size();
+  for(int32_t i = msb; ; i += (lsb < msb ? -1 : 1)) {
+    _name.append(1, '[').append(std::to_string(i)).append(1, ']');
+    n.nets.insert(_name);
+    _name.resize(size);
+    if(i == lsb) {
       break;
     }
-    else {
-      
-      Gate inst;
-      inst.cell = std::move(*itr);
+  }
+
+  return true;
+}
+
+// Function: _gate
+// CELL name ( .A(n1), .B(bus[2]), .C() );
+template <typename I>
+bool StatementReader<I>::_gate() {
+
+  auto& n = _netlist;
+
+  if(!_identifier(_name)) {
+    return false;
+  }
+  const auto cell = intern(_name);
+
+  if(!_identifier(_name)) {
+    return false;
+  }
+  if(const auto size = n.gates.size(); n.gates.insert(_name) != size) {
+    return _fail("duplicate gate");
+  }
 
-      if(++itr == end) {
-        OT_LOGF("syntax error in cell ", inst.cell, ")");
+  n.gate_cells.push_back(cell);
+
+  if(!_expect("(")) {
+    return false;
+  }
+
+  if(!_accept(")")) {
+    do {
+      uint32_t net;
+      if(!_expect(".") || !_identifier(_name)) {
+        return false;
+      }
+      const auto pin = intern(_name);
+      if(!_expect("(") || !_net(net) || !_expect(")")) {
+        return false;
       }
-      inst.name = std::move(*itr);
+      n.pin_names.push_back(pin);
+      n.pin_nets.push_back(net);
+    } while(_accept(","));
 
-      // Read the mapping
-      std::string cellpin;
-      std::string net;
+    if(!_expect(")")) {
+      return false;
+    }
+  }
 
-      itr = on_next_parentheses(itr, end, [&] (auto& str) mutable { 
-        if(str == ")" || str == "(") {
-          return;
-        }
-        else if(str[0] == '.') {
-          cellpin = str.substr(1);
+  n.pin_offsets.push_back(n.pin_names.size());
+
+  return _expect(";");
+}
+
+// Function: _net
+// A net, a bit of a bus, or nothing for an unconnected pin.
+template <typename I>
+bool StatementReader<I>::_net(uint32_t& net) {
+
+  if(_token() == ")") {
+    net = Netlist::NONE;
+    return true;
+  }
+
+  if(!_identifier(_name)) {
+    return false;
+  }
+
+  if(_accept("[")) {
+    int32_t bit;
+    if(!_integer(bit) || !_expect("]")) {
+      return false;
+    }
+    _name.append(1, '[').append(std::to_string(bit)).append(1, ']');
+  }
+
+  net = _netlist.nets.insert(_name);
+
+  return true;
+}
+
+// Function: append
+// Append a netlist read from a later chunk, renumbering its nets and
+// buses. Return false on a gate already defined.
+bool append(Netlist& to, Netlist& from) {
+
+  std::vector<uint32_t> nets(from.nets.size()), buses(from.buses.size());
+
+  for(uint32_t i=0; i<nets.size(); ++i) {
+    nets[i] = to.nets.insert(from.nets[i]);
+  }
+  for(uint32_t i=0; i<buses.size(); ++i) {
+    buses[i] = to.buses.insert(from.buses[i]);
+  }
+
+  for(auto d : from.declarations) {
+    d.name = d.bus ? buses[d.name] : nets[d.name];
+    to.declarations.push_back(d);
+  }
+
+  for(uint32_t g=0; g<from.gates.size(); ++g) {
+    if(const auto size = to.gates.size(); to.gates.insert(from.gates[g]) != size) {
+      std::cerr << "duplicate gate " << from.gates[g] << '\n';
+      return false;
+    }
+  }
+
+  to.gate_cells.insert(to.gate_cells.end(), from.gate_cells.begin(), from.gate_cells.end());
+  to.pin_names.insert(to.pin_names.end(), from.pin_names.begin(), from.pin_names.end());
+
+  const auto base = to.pin_offsets.back();
+  for(size_t g=1; g<from.pin_offsets.size(); ++g) {
+    to.pin_offsets.push_back(base + from.pin_offsets[g]);
+  }
+
+  for(const auto net : from.pin_nets) {
+    to.pin_nets.push_back(net == Netlist::NONE ? net : nets[net]);
+  }
+
+  from = Netlist();
+
+  return true;
+}
+
+};  // end of anonymous namespace. ----------------------------------------------------------------
+
+// Function: read_verilog
+// Read the first module of a structural verilog file. Escaped identifiers,
+// e.g., "\n1[0] ", are names like any other; continuous assignments are not
+// supported and fail the read. With one thread, or from a pipe, tokens are
+// pulled lazily from the input in constant memory. Otherwise the file is
+// mapped and split right after semicolons into chunks that are tokenized and
+// read in parallel, then appended in file order, so the result does not
+// depend on the number of threads. Semicolons inside comments are passed over
+// when splitting, as far as a look back over the current chunk can tell; a
+// chunk still cut inside a comment or an escaped identifier is caught by the
+// tokenizer, and the rest of the file is then read in one piece. Errors are
+// reported on std::cerr.
+std::optional<Netlist> read_verilog(const std::filesystem::path& path, unsigned num_threads) {
+
+  // Chunk size, and smallest file worth splitting
+  constexpr size_t chunk_size {4 << 20};
+
+  Netlist netlist;
+
+  const Tokenizer tokenizer(delimiters, delimiters, true, true);
+
+  MappedFile file;
+
+  if(num_threads <= 1 || !std::filesystem::is_regular_file(path) ||
+     !file.open(path) || file.size() < 2 * chunk_size) {
+
+    TokenStream tokens(path, delimiters, delimiters, true);
+
+    if(!tokens.good()) {
+      std::cerr << "failed to open " << path << '\n';
+      return std::nullopt;
+    }
+
+    StatementReader reader(tokens.begin(), tokens.end(), netlist, false);
+
+    if(!reader.read()) {
+      std::cerr << path << ": " << reader.error() << '\n';
+      return std::nullopt;
+    }
+    if(!reader.closed()) {
+      std::cerr << path << ": missing module or endmodule\n";
+      return std::nullopt;
+    }
+    return netlist;
+  }
+
+  const auto buffer = file.view();
+
+  // Speculative split points right after semicolons, skipping those on a line
+  // comment or in a block comment. Block comments are tracked by a forward
+  // scan from the last split point, so the pre-scan stays linear.
+  std::vector<size_t> bounds {0};
+  for(size_t pos = chunk_size; pos < buffer.size(); pos = bounds.back() + chunk_size) {
+    size_t scan = bounds.back();
+    bool in_block {false};
+    while((pos = buffer.find(';', pos)) != std::string_view::npos) {
+      while(scan < pos) {
+        const auto mark = buffer.substr(scan, pos - scan).find(in_block ? "*/" : "/*");
+        if(mark == std::string_view::npos) {
+          scan = pos;
         }
         else {
-          net = str; 
-          inst.cellpin2net[cellpin] = net;
-          inst.net2cellpin[net] = cellpin;
+          scan += mark + 2;
+          in_block = !in_block;
         }
-      });
-
-      if(itr == end) {
-        OT_LOGF("syntax error in gate pin-net mapping");
       }
-      
-      module.gates.push_back(std::move(inst));
+      const auto line = buffer.rfind('\n', pos);
+      const auto beg = (line == std::string_view::npos) ? 0 : line + 1;
+      if(in_block) {
+        pos = buffer.find("*/", pos);
+      }
+      else if(buffer.substr(beg, pos - beg).find("//") != std::string_view::npos) {
+        pos = buffer.find('\n', pos);
+      }
+      else {
+        break;
+      }
+    }
+    if(pos == std::string_view::npos || pos + 1 >= buffer.size()) {
+      break;
     }
+    bounds.push_back(pos + 1);
   }
-  
-  return module;
-}
+  bounds.push_back(buffer.size());
+
+  const size_t num_chunks = bounds.size() - 1;
+
+  std::vector<Netlist> parts(num_chunks);
+  std::vector<std::string> errors(num_chunks);
+  std::vector<char> complete(num_chunks, 0);
+  std::vector<char> closed(num_chunks, 0);
+
+  // Read the chunks [b, e) as one; the last chunk is always complete
+  auto read = [&] (size_t b, size_t e) {
+    std::vector<std::string_view> tokens;
+    const auto chunk = buffer.substr(bounds[b], bounds[e] - bounds[b]);
+    if(e == num_chunks) {
+      tokenizer.tokenize(chunk, tokens);
+      complete[b] = 1;
+    }
+    else {
+      complete[b] = (tokenizer.tokenize_partial(chunk, tokens) == chunk.size());
+    }
+    parts[b] = Netlist();
+    StatementReader reader(tokens.begin(), tokens.end(), parts[b], b != 0);
+    errors[b] = reader.read() ? std::string() : reader.error();
+    closed[b] = reader.closed();
+  };
 
+  parallel_for(num_chunks, num_threads, [&] (size_t i) { read(i, i + 1); });
+
+  // Append the chunks in order up to "endmodule"
+  for(size_t i=0, e=1; i<num_chunks; i=e++) {
+
+    if(!complete[i]) {
+      read(i, e = num_chunks);
+    }
+
+    if(!errors[i].empty()) {
+      std::cerr << path << ": " << errors[i] << '\n';
+      return std::nullopt;
+    }
+
+    if(i == 0) {
+      netlist = std::move(parts[0]);
+    }
+    else if(!append(netlist, parts[i])) {
+      return std::nullopt;
+    }
+
+    if(closed[i]) {
+      return netlist;
+    }
+  }
+
+  std::cerr << path << ": missing module or endmodule\n";
+
+  return std::nullopt;
+}
 
 
-};  // end of namespace ot. -----------------------------------------------------------------------
+};  // end of namespace sda::des. -----------------------------------------------------------------
@@ -1,45 +1,92 @@
-#ifndef OT_VERILOG_VERILOG_HPP_
-#define OT_VERILOG_VERILOG_HPP_
+#ifndef SDA_DES_MODULE_HPP_
+#define SDA_DES_MODULE_HPP_
 
-#include <ot/headerdef.hpp>
-#include <ot/static/logger.hpp>
-#include <ot/utility/utility.hpp>
+#include <cstdint>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <experimental/filesystem>
+#include <sda/utility/names.hpp>
+#include <sda/utility/symbol.hpp>
 
-namespace ot::des {
-
-// Struct: Gate
-struct Gate {
-  std::string name;
-  std::string cell;
-  std::unordered_map<std::string, std::string> cellpin2net;
-  std::unordered_map<std::string, std::string> net2cellpin;
+namespace std {
+  namespace filesystem = experimental::filesystem;
 };
 
-std::ostream& operator << (std::ostream&, const Gate&);
+namespace sda::des {
 
-// ------------------------------------------------------------------------------------------------
+// Struct: Netlist
+// A flat gate-level verilog module in compact, structure-of-arrays form, so
+// that netlists of tens of millions of gates fit in memory. Nets are single
+// bits (e.g., "n1" or "bus[3]") and, like gates, are numbered densely in
+// order of first appearance through local name tables. Cell types and pin
+// names are few and shared, so they are symbols. The pins of gate g are
+// [pin_offsets[g], pin_offsets[g+1]) in pin_names and pin_nets. An
+// unconnected pin has net NONE.
+struct Netlist {
+
+  static constexpr uint32_t NONE {NameTable::NONE};
+
+  enum class Direction : uint8_t {
+    INPUT = 0,
+    OUTPUT,
+    INOUT,
+    WIRE
+  };
+
+  // Struct: Declaration
+  // A declared net, or a bus [msb:lsb] of the nets "name[i]". The name is a
+  // net id for a single net and a bus id for a bus.
+  struct Declaration {
+    Direction direction {Direction::WIRE};
+    bool bus {false};
+    uint32_t name {NONE};
+    int32_t msb {0};
+    int32_t lsb {0};
+  };
 
-// Struct: Module
-struct Module {
   std::string name;
   std::vector<std::string> ports;
-  std::vector<std::string> wires;
-  std::vector<std::string> inputs;
-  std::vector<std::string> outputs;
-  std::vector<Gate> gates;
+  std::vector<Declaration> declarations;
+
+  NameTable nets;
+  NameTable buses;
+  NameTable gates;
+
+  // gate id -> cell type
+  std::vector<Symbol> gate_cells;
+
+  // pin id -> pin name, net id
+  std::vector<uint64_t> pin_offsets {0};
+  std::vector<Symbol> pin_names;
+  std::vector<uint32_t> pin_nets;
+
+  size_t num_gates() const;
+  size_t num_pins() const;
+  size_t memory() const;
+
   std::string info() const;
 };
 
-std::ostream& operator << (std::ostream&, const Module&);
+std::ostream& operator << (std::ostream&, const Netlist&);
 
 // ------------------------------------------------------------------------------------------------
 
-Module read_verilog(const std::filesystem::path&);
+std::optional<Netlist> read_verilog(
+  const std::filesystem::path&,
+  unsigned = std::thread::hardware_concurrency()
+);
 
-};  // end of namespace ot. -----------------------------------------------------------------------
-
-
-#endif
+bool write_verilog(
+  const std::filesystem::path&,
+  const Netlist&,
+  unsigned = std::thread::hardware_concurrency()
+);
 
+};  // end of namespace sda::des. -----------------------------------------------------------------
 
 
+#endif
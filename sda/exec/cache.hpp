@@ -0,0 +1,483 @@
+#ifndef SDA_EXEC_CACHE_HPP_
+#define SDA_EXEC_CACHE_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <charconv>
+#include <cstdint>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+#include <fcntl.h>
+#include <sys/ioctl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <linux/fs.h>
+#include <experimental/filesystem>
+#include <sda/utility/hash.hpp>
+#include <sda/utility/mmap.hpp>
+
+namespace std {
+  namespace filesystem = experimental::filesystem;
+};
+
+namespace sda {
+
+// Class: ActionCache
+// Content-addressed cache of tool runs in a local directory:
+//
+//   cas/<xx>/<hash>[x]   file contents by hash, read-only; x if executable
+//   ac/<xx>/<key>        manifest of the outputs of the action with this key
+//   tmp/                 files being written, renamed into place when done
+//
+// The key of an action is computed by its user, e.g., the Executor, and
+// must cover everything the outputs depend on. The outputs of an action
+// are files and directories under a root directory, named relative to it.
+// They are restored as reflinks where the file system can share extents, as
+// hard links to the read-only blobs otherwise, and as copies only across
+// file systems. Hashes are 64-bit XXH64, which is fine for a local cache but
+// not meant to be shared with untrusted users.
+class ActionCache {
+
+  public:
+
+    ActionCache(const std::filesystem::path&);
+
+    bool good() const;
+
+    const std::filesystem::path& dir() const;
+
+    ActionCache& environment(std::vector<std::string>);
+    const std::vector<std::string>& environment() const;
+
+    bool restore(uint64_t, const std::filesystem::path&);
+    bool store(uint64_t, const std::filesystem::path&, const std::vector<std::string>&);
+
+    size_t num_hits() const;
+    size_t num_misses() const;
+
+    static uint64_t digest(const std::filesystem::path&);
+
+  private:
+
+    enum Method : int {
+      CLONE = 0,
+      LINK,
+      COPY
+    };
+
+    std::filesystem::path _dir;
+    bool _good {false};
+
+    // variables of the environment that tools depend on
+    std::vector<std::string> _environment {"PATH", "LD_LIBRARY_PATH"};
+
+    std::atomic<int> _method {CLONE};
+    std::atomic<size_t> _num_tmp {0};
+    std::atomic<size_t> _num_hits {0};
+    std::atomic<size_t> _num_misses {0};
+
+    std::filesystem::path _blob(uint64_t, bool) const;
+    std::filesystem::path _manifest(uint64_t) const;
+    std::filesystem::path _tmp();
+
+    bool _put(const std::filesystem::path&, uint64_t&, bool&);
+    bool _get(const std::filesystem::path&, const std::filesystem::path&, bool);
+    bool _copy(const std::filesystem::path&, const std::filesystem::path&, bool);
+
+    static std::string _hex(uint64_t);
+};
+
+// Constructor
+inline ActionCache::ActionCache(const std::filesystem::path& dir) : _dir {dir} {
+  std::error_code ec;
+  for(auto sub : {"cas", "ac", "tmp"}) {
+    std::filesystem::create_directories(_dir / sub, ec);
+  }
+  _good = !ec;
+  if(_good) {
+    _dir = std::filesystem::absolute(_dir);
+  }
+}
+
+// Function: good
+inline bool ActionCache::good() const {
+  return _good;
+}
+
+// Function: dir
+inline const std::filesystem::path& ActionCache::dir() const {
+  return _dir;
+}
+
+// Function: environment
+// Set the variables of the environment that are part of the action keys.
+inline ActionCache& ActionCache::environment(std::vector<std::string> names) {
+  _environment = std::move(names);
+  return *this;
+}
+
+// Function: environment
+inline const std::vector<std::string>& ActionCache::environment() const {
+  return _environment;
+}
+
+// Function: num_hits
+inline size_t ActionCache::num_hits() const {
+  return _num_hits;
+}
+
+// Function: num_misses
+inline size_t ActionCache::num_misses() const {
+  return _num_misses;
+}
+
+// Function: _hex
+inline std::string ActionCache::_hex(uint64_t h) {
+  std::string s(16, '0');
+  char buf[16];
+  auto [end, ec] = std::to_chars(buf, buf + sizeof(buf), h, 16);
+  std::copy(buf, end, s.end() - (end - buf));
+  return s;
+}
+
+// Function: _blob
+inline std::filesystem::path ActionCache::_blob(uint64_t hash, bool exec) const {
+  const auto hex {_hex(hash)};
+  return _dir / "cas" / hex.substr(0, 2) / (exec ? hex + 'x' : hex);
+}
+
+// Function: _manifest
+inline std::filesystem::path ActionCache::_manifest(uint64_t key) const {
+  const auto hex {_hex(key)};
+  return _dir / "ac" / hex.substr(0, 2) / hex;
+}
+
+// Function: _tmp
+// A fresh path in tmp/ that no other writer uses.
+inline std::filesystem::path ActionCache::_tmp() {
+  return _dir / "tmp" / (std::to_string(::getpid()) + '.' + std::to_string(_num_tmp++));
+}
+
+// Function: digest
+// Hash the content of a file, or of every file under a directory together
+// with their relative paths. A missing path has digest 0.
+inline uint64_t ActionCache::digest(const std::filesystem::path& path) {
+
+  std::error_code ec;
+
+  if(std::filesystem::is_regular_file(path, ec)) {
+    MappedFile file(path);
+    return file.good() ? hash64(file.view(), 1) : 0;
+  }
+
+  if(!std::filesystem::is_directory(path, ec)) {
+    return 0;
+  }
+
+  std::vector<std::pair<std::string, uint64_t>> files;
+  for(auto itr = std::filesystem::recursive_directory_iterator(path, ec);
+      !ec && itr != std::filesystem::recursive_directory_iterator(); itr.increment(ec)) {
+    if(std::filesystem::is_regular_file(itr->status())) {
+      const auto rel {itr->path().string().substr(path.string().size())};
+      files.emplace_back(rel, digest(itr->path()));
+    }
+  }
+  std::sort(files.begin(), files.end());
+
+  uint64_t h {2};
+  for(const auto& [rel, d] : files) {
+    h = hash64(rel, h ^ d);
+  }
+  return h;
+}
+
+// Function: _copy
+// Copy a file with its permissions, as a reflink if clone is set and the
+// file system supports it.
+inline bool ActionCache::_copy(const std::filesystem::path& from, const std::filesystem::path& to, bool clone) {
+
+  const int in = ::open(from.c_str(), O_RDONLY | O_CLOEXEC);
+  if(in == -1) {
+    return false;
+  }
+
+  struct stat st;
+  const int out = (::fstat(in, &st) == -1) ? -1 :
+    ::open(to.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, st.st_mode & 0777);
+
+  bool ok = (out != -1);
+
+  if(ok && !(clone && ::ioctl(out, FICLONE, in) == 0)) {
+
+    // copy_file_range stays in the kernel and may share extents as well;
+    // where it is not supported, e.g., across some file systems, read and
+    // write the rest
+    bool kernel {true};
+
+    for(off_t left = st.st_size; left > 0; ) {
+
+      ssize_t ret;
+
+      if(kernel) {
+        ret = ::copy_file_range(in, nullptr, out, nullptr, left, 0);
+        if(ret == -1 && (errno == EXDEV || errno == EINVAL || errno == EOPNOTSUPP || errno == ENOSYS)) {
+          kernel = false;
+          continue;
+        }
+      }
+      else {
+        char buf[1 << 16];
+        ret = ::read(in, buf, std::min<off_t>(left, sizeof(buf)));
+        for(ssize_t w=0; w<ret; ) {
+          auto k = ::write(out, buf + w, ret - w);
+          if(k == -1 && errno != EINTR) {
+            ret = -1;
+            break;
+          }
+          w += std::max<ssize_t>(k, 0);
+        }
+      }
+
+      if(ret <= 0) {
+        if(ret == -1 && errno == EINTR) {
+          continue;
+        }
+        ok = false;
+        break;
+      }
+
+      left -= ret;
+    }
+  }
+
+  ::close(in);
+  if(out != -1 && ::close(out) == -1) {
+    ok = false;
+  }
+
+  return ok;
+}
+
+// Function: _put
+// Add a file to the content store unless it is there already.
+inline bool ActionCache::_put(const std::filesystem::path& file, uint64_t& hash, bool& exec) {
+
+  struct stat st;
+  if(::stat(file.c_str(), &st) == -1) {
+    return false;
+  }
+
+  hash = digest(file);
+  exec = (st.st_mode & S_IXUSR) != 0;
+
+  const auto blob {_blob(hash, exec)};
+
+  if(::access(blob.c_str(), F_OK) == 0) {
+    return true;
+  }
+
+  std::error_code ec;
+  std::filesystem::create_directories(blob.parent_path(), ec);
+
+  // Written aside and renamed, so a blob is either whole or absent
+  const auto tmp {_tmp()};
+  if(!_copy(file, tmp, true) || ::chmod(tmp.c_str(), exec ? 0555 : 0444) == -1 ||
+     ::rename(tmp.c_str(), blob.c_str()) == -1) {
+    ::unlink(tmp.c_str());
+    return false;
+  }
+
+  return true;
+}
+
+// Function: _get
+// Restore a blob at a path: a reflink, a hard link, or a copy, whichever is
+// the first that works. A method that fails for lack of support is not
+// tried again.
+inline bool ActionCache::_get(const std::filesystem::path& blob, const std::filesystem::path& to, bool exec) {
+
+  ::unlink(to.c_str());
+
+  if(_method == CLONE) {
+    if(const int in = ::open(blob.c_str(), O_RDONLY | O_CLOEXEC); in != -1) {
+      const int out = ::open(to.c_str(), O_WRONLY | O_CREAT | O_EXCL | O_CLOEXEC, exec ? 0755 : 0644);
+      const bool cloned = (out != -1 && ::ioctl(out, FICLONE, in) == 0);
+      const int err = errno;
+      ::close(in);
+      if(out != -1) {
+        ::close(out);
+      }
+      if(cloned) {
+        return true;
+      }
+      ::unlink(to.c_str());
+      if(err == EOPNOTSUPP || err == ENOTTY || err == EXDEV || err == EINVAL || err == ENOSYS) {
+        _method = LINK;
+      }
+    }
+  }
+
+  if(_method <= LINK) {
+    if(::link(blob.c_str(), to.c_str()) == 0) {
+      return true;
+    }
+    if(errno == EXDEV || errno == EPERM) {
+      _method = COPY;
+    }
+  }
+
+  if(!_copy(blob, to, false)) {
+    return false;
+  }
+
+  // Copies are the tool's to modify, unlike links to the store
+  return ::chmod(to.c_str(), exec ? 0755 : 0644) == 0;
+}
+
+// Function: restore
+// Restore the outputs of the action with the key under the root. Returns
+// false if the action is not cached or an output cannot be restored.
+inline bool ActionCache::restore(uint64_t key, const std::filesystem::path& root) {
+
+  std::ifstream ifs(_manifest(key));
+
+  std::string line;
+
+  if(!ifs || !std::getline(ifs, line) || line != "sda-action 1") {
+    ++_num_misses;
+    return false;
+  }
+
+  // Each line is "d <path>" for a directory or "f <hash><x> <path>" for a file
+  std::vector<std::pair<std::filesystem::path, std::filesystem::path>> files;
+  std::vector<std::filesystem::path> dirs;
+
+  while(std::getline(ifs, line)) {
+    if(line.size() > 2 && line.compare(0, 2, "d ") == 0) {
+      dirs.push_back(root / line.substr(2));
+    }
+    else if(const auto sp {line.find(' ', 2)};
+            line.compare(0, 2, "f ") == 0 && sp >= 18 && sp + 1 < line.size()) {
+      const auto hex {line.substr(2, sp - 2)};
+      files.emplace_back(_dir / "cas" / hex.substr(0, 2) / hex, root / line.substr(sp + 1));
+    }
+    else {
+      ++_num_misses;
+      return false;
+    }
+  }
+
+  // Every blob must still be there before anything is touched
+  for(const auto& [blob, to] : files) {
+    if(::access(blob.c_str(), F_OK) != 0) {
+      ++_num_misses;
+      return false;
+    }
+  }
+
+  std::error_code ec;
+
+  for(const auto& d : dirs) {
+    std::filesystem::create_directories(d, ec);
+  }
+
+  for(const auto& [blob, to] : files) {
+    std::filesystem::create_directories(to.parent_path(), ec);
+    if(!_get(blob, to, blob.string().back() == 'x')) {
+      ++_num_misses;
+      return false;
+    }
+  }
+
+  ++_num_hits;
+
+  return true;
+}
+
+// Function: store
+// Cache the outputs, paths relative to the root, of the action with the key.
+// Outputs that do not exist are left out and are not restored. Returns false
+// if an output is neither a file nor a directory or cannot be stored.
+inline bool ActionCache::store(
+  uint64_t key, const std::filesystem::path& root, const std::vector<std::string>& outputs
+) {
+
+  std::string manifest {"sda-action 1\n"};
+
+  auto add = [&] (const std::filesystem::path& file, const std::string& rel) {
+    uint64_t hash;
+    bool exec;
+    if(!_put(file, hash, exec)) {
+      return false;
+    }
+    manifest += "f " + _hex(hash) + (exec ? "x " : " ") + rel + '\n';
+    return true;
+  };
+
+  std::error_code ec;
+
+  for(const auto& rel : outputs) {
+
+    const auto path {root / rel};
+    const auto status {std::filesystem::symlink_status(path, ec)};
+
+    if(!std::filesystem::exists(status)) {
+      continue;
+    }
+
+    if(std::filesystem::is_regular_file(status)) {
+      if(!add(path, rel)) {
+        return false;
+      }
+      continue;
+    }
+
+    if(!std::filesystem::is_directory(status)) {
+      return false;
+    }
+
+    manifest += "d " + rel + '\n';
+
+    for(auto itr = std::filesystem::recursive_directory_iterator(path, ec);
+        !ec && itr != std::filesystem::recursive_directory_iterator(); itr.increment(ec)) {
+      const auto sub {rel + itr->path().string().substr(path.string().size())};
+      const auto s {itr->symlink_status()};
+      if(std::filesystem::is_directory(s)) {
+        manifest += "d " + sub + '\n';
+      }
+      else if(!std::filesystem::is_regular_file(s) || !add(itr->path(), sub)) {
+        return false;
+      }
+    }
+
+    if(ec) {
+      return false;
+    }
+  }
+
+  // Manifests are replaced atomically as well
+  const auto path {_manifest(key)};
+  const auto tmp {_tmp()};
+
+  std::filesystem::create_directories(path.parent_path(), ec);
+
+  std::ofstream ofs(tmp);
+  ofs << manifest;
+  ofs.close();
+
+  if(!ofs || ::rename(tmp.c_str(), path.c_str()) == -1) {
+    ::unlink(tmp.c_str());
+    return false;
+  }
+
+  return true;
+}
+
+
+};  // end of namespace sda. ----------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,1009 @@
+#ifndef SDA_EXEC_EXECUTOR_HPP_
+#define SDA_EXEC_EXECUTOR_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <functional>
+#include <iostream>
+#include <memory>
+#include <numeric>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <fcntl.h>
+#include <spawn.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <experimental/filesystem>
+#include <sda/des/csr.hpp>
+#include <sda/exec/cache.hpp>
+#include <sda/exec/relay.hpp>
+#include <sda/tech/tech.hpp>
+#include <sda/utility/threadpool.hpp>
+
+extern char** environ;
+
+namespace std {
+  namespace filesystem = experimental::filesystem;
+};
+
+namespace sda {
+
+// Class: Executor
+// Run a flattened, frozen flow graph (see Des::Graph::freeze). Every vertex
+// is a leaf cell whose tool binary, given by the tech library, is launched
+// as soon as the cells driving all of its incoming dependency wires have
+// finished successfully. Tasks run on a work-stealing pool of num_workers
+// threads, each of which waits for the process it launched, so at most
+// num_workers tools run at once (make -j). A cell that becomes ready is
+// queued on the worker that finished its last input, which keeps chains of
+// cells on one worker.
+//
+// A tool runs in the work directory with its standard output and error
+// written to <instance>.log there, and finds its context in the environment:
+//
+//   SDA_CELL      cell name
+//   SDA_INSTANCE  instance path
+//   SDA_WORK_DIR  work directory
+//   SDA_INPUTS    ':'-separated paths of the wires into the instance
+//   SDA_OUTPUTS   ':'-separated paths of the wires out of the instance
+//
+// Cells connected by stream wires form a group that runs as one task: all of
+// its tools are launched together, each stream wire becomes a pipe from its
+// producer to its consumer, and the group finishes when every tool has
+// exited, so a chain of streaming stages takes about as long as its slowest
+// stage. A group holds one worker while it runs. The ends of the stream
+// wires of a tool are passed as inherited descriptors, or with fifos(true)
+// as named pipes created in the work directory for tools that need a path:
+//
+//   SDA_STREAM_INPUTS   ':'-separated <wire>=<path> to read stream wires from
+//   SDA_STREAM_OUTPUTS  ':'-separated <wire>=<path> to write stream wires to
+//
+// where the path is /dev/fd/<n> for a pipe, and /dev/null for a stream wire
+// to or from a port. Dependency wires between cells of the same group would
+// deadlock and are rejected. pipe_size resizes the stream pipes; a larger
+// buffer means fewer wakeups when the two ends run on different cores, but a
+// larger cache footprint when they share one.
+//
+// With relay(true), each stream wire runs through a Relay: the producer and
+// the consumer get a pipe each and a thread splices one into the other,
+// counting the traffic and the backpressure of the wire (see relay_stats).
+// tap(true) also copies every stream to <wire>.stream in the work directory.
+// Relays need inherited pipes and do not work with FIFOs.
+//
+// The artifact of a dependency wire is the file or directory at the path of
+// the wire in the work directory; the parent directories of its outputs
+// exist when a tool starts. With an ActionCache, a cell that does not stream
+// is keyed by its tech entry, the content of its binary, its instance and
+// wires, the environment variables the cache names, and the content of its
+// input artifacts. On a hit its output artifacts and log are restored from
+// the cache instead of running the tool (State::CACHED); otherwise they are
+// removed, so the tool writes fresh files, and stored once it succeeds.
+//
+// A failed tool, i.e., one that cannot be launched or exits with a nonzero
+// status, stops everything downstream of it and the rest of its group;
+// independent cells still run. A group whose stream wires cannot be created
+// fails as a whole.
+class Executor {
+
+  public:
+
+    enum class State : uint8_t {
+      PENDING = 0,
+      DONE,
+      CACHED,
+      FAILED,
+      SKIPPED
+    };
+
+    Executor(const des::CsrGraph&, const TechLibrary&);
+
+    Executor& num_workers(unsigned);
+    Executor& work_dir(const std::filesystem::path&);
+    Executor& fifos(bool);
+    Executor& pipe_size(size_t);
+    Executor& relay(bool);
+    Executor& tap(bool);
+    Executor& cache(ActionCache*);
+
+    bool run();
+
+    State state(uint32_t) const;
+    int exit_status(uint32_t) const;
+
+    size_t num_launched() const;
+    size_t num_groups() const;
+    size_t num_cached() const;
+
+    const RelayStats& relay_stats(uint32_t) const;
+
+  private:
+
+    // Struct: Channel
+    // A stream wire between two cells of a group: the pipe ends of the
+    // consumer and the producer, or a FIFO path. A relayed wire also has the
+    // ends of the relay and its tap.
+    struct Channel {
+      int fds[2] {-1, -1};
+      int relay[2] {-1, -1};
+      int tap {-1};
+      std::string path;
+    };
+
+    const des::CsrGraph& _graph;
+    const TechLibrary& _tech;
+
+    unsigned _num_workers {std::thread::hardware_concurrency()};
+    std::filesystem::path _work_dir {"."};
+    bool _fifos {false};
+    bool _relay {false};
+    bool _tap {false};
+    size_t _pipe_size {0};
+
+    ActionCache* _cache {nullptr};
+
+    // vertex id -> cell
+    std::vector<const TechCell*> _cells;
+
+    // cell -> absolute path of its binary, and its content hash if cached
+    std::unordered_map<const TechCell*, std::string> _binaries;
+    std::unordered_map<const TechCell*, uint64_t> _binary_hashes;
+
+    // vertex id -> state, exit status
+    std::vector<State> _states;
+    std::vector<int> _statuses;
+
+    // vertex id -> group; the members of group g, in vertex order, are
+    // _members[_group_offsets[g] .. _group_offsets[g+1])
+    std::vector<uint32_t> _groups;
+    std::vector<uint32_t> _group_offsets;
+    std::vector<uint32_t> _members;
+
+    // group -> number of unfinished dependency inputs
+    std::unique_ptr<std::atomic<uint32_t>[]> _pending;
+
+    std::atomic<size_t> _num_launched {0};
+    std::atomic<size_t> _num_cached {0};
+
+    // edge id -> traffic of its relay
+    std::unique_ptr<RelayStats[]> _relay_stats;
+
+    bool _prepare();
+    bool _group();
+    bool _run(uint32_t);
+    bool _open(uint32_t, Channel&) const;
+    pid_t _launch(uint32_t, const std::unordered_map<uint32_t, Channel>&);
+    bool _wait(des::CsrGraph::Span, std::vector<pid_t>&);
+    bool _reap(uint32_t, int, bool);
+
+    des::CsrGraph::Span _members_of(uint32_t) const;
+
+    uint64_t _key(uint32_t) const;
+    std::vector<std::string> _outputs(uint32_t) const;
+
+    std::string _join_edges(des::CsrGraph::Span) const;
+
+    static std::filesystem::path _binary(const TechCell&);
+};
+
+// Constructor
+inline Executor::Executor(const des::CsrGraph& graph, const TechLibrary& tech) :
+  _graph {graph}, _tech {tech} {
+}
+
+// Function: num_workers
+inline Executor& Executor::num_workers(unsigned n) {
+  _num_workers = std::max(n, 1u);
+  return *this;
+}
+
+// Function: work_dir
+inline Executor& Executor::work_dir(const std::filesystem::path& dir) {
+  _work_dir = dir;
+  return *this;
+}
+
+// Function: fifos
+// Pass stream wires as named pipes in the work directory instead of
+// inherited descriptors.
+inline Executor& Executor::fifos(bool on) {
+  _fifos = on;
+  return *this;
+}
+
+// Function: pipe_size
+// The buffer size of stream pipes, or 0 to keep the system default.
+inline Executor& Executor::pipe_size(size_t bytes) {
+  _pipe_size = bytes;
+  return *this;
+}
+
+// Function: relay
+// Relay stream wires with splice(2) to count their traffic.
+inline Executor& Executor::relay(bool on) {
+  _relay = on;
+  return *this;
+}
+
+// Function: tap
+// Relay stream wires and copy them to the work directory.
+inline Executor& Executor::tap(bool on) {
+  _tap = on;
+  return *this;
+}
+
+// Function: cache
+// Restore the outputs of unchanged cells from an action cache, or nullptr.
+inline Executor& Executor::cache(ActionCache* cache) {
+  _cache = cache;
+  return *this;
+}
+
+// Function: relay_stats
+// The traffic of a stream wire in the last run; zero unless it was relayed,
+// including before the first run and for an edge out of range.
+inline const RelayStats& Executor::relay_stats(uint32_t e) const {
+  static const RelayStats zero;
+  if(!_relay_stats || e >= _graph.num_edges()) {
+    return zero;
+  }
+  return _relay_stats[e];
+}
+
+// Function: state
+inline Executor::State Executor::state(uint32_t v) const {
+  return _states[v];
+}
+
+// Function: exit_status
+// The exit status of the tool of a vertex, or -1 if it was not launched or
+// did not exit normally.
+inline int Executor::exit_status(uint32_t v) const {
+  return _statuses[v];
+}
+
+// Function: num_launched
+inline size_t Executor::num_launched() const {
+  return _num_launched;
+}
+
+// Function: num_groups
+// The number of tasks of the last run, i.e., the groups of cells connected
+// by stream wires, counting lone cells as groups of one.
+inline size_t Executor::num_groups() const {
+  return _group_offsets.empty() ? 0 : _group_offsets.size() - 1;
+}
+
+// Function: num_cached
+// The number of cells of the last run restored from the action cache.
+inline size_t Executor::num_cached() const {
+  return _num_cached;
+}
+
+// Function: _members_of
+inline des::CsrGraph::Span Executor::_members_of(uint32_t g) const {
+  return {_members.data() + _group_offsets[g], _members.data() + _group_offsets[g+1]};
+}
+
+// Function: _binary
+// The binary of a cell, relative to the directory of its .tech file unless
+// absolute. Tools run in the work directory, so the path is made absolute.
+inline std::filesystem::path Executor::_binary(const TechCell& cell) {
+  std::filesystem::path binary {cell.binary};
+  return std::filesystem::absolute(binary.is_absolute() ? binary : cell.directory / binary);
+}
+
+// Function: _prepare
+// Resolve the cell of every vertex and check the graph can run.
+inline bool Executor::_prepare() {
+
+  const auto V {_graph.num_vertices()};
+
+  _cells.assign(V, nullptr);
+  _states.assign(V, State::PENDING);
+  _statuses.assign(V, -1);
+  _num_launched = 0;
+  _num_cached = 0;
+  _relay_stats = std::make_unique<RelayStats[]>(_graph.num_edges());
+
+  bool ok {true};
+
+  if(_fifos && (_relay || _tap)) {
+    std::cerr << "stream wires passed as FIFOs cannot be relayed\n";
+    ok = false;
+  }
+
+  for(uint32_t v=0; v<V; ++v) {
+    _cells[v] = _tech.find(_graph.vertex_cells[v]);
+    if(_cells[v] == nullptr) {
+      std::cerr << "no tech cell " << name_of(_graph.vertex_cells[v])
+                << " for instance " << render(_graph.vertex_names[v]) << '\n';
+      ok = false;
+    }
+  }
+
+  if(!ok) {
+    return false;
+  }
+
+  // Resolve and check the binary of each cell used, once
+  _binaries.clear();
+  for(const auto cell : _cells) {
+    if(auto [itr, inserted] = _binaries.try_emplace(cell); inserted) {
+      itr->second = _binary(*cell).string();
+      if(::access(itr->second.c_str(), X_OK) != 0) {
+        std::cerr << "cell " << name_of(cell->name) << ": cannot execute " << itr->second << '\n';
+        ok = false;
+      }
+    }
+  }
+
+  if(!_group()) {
+    ok = false;
+  }
+
+  // Hash each binary used once; a rebuilt tool invalidates its actions
+  _binary_hashes.clear();
+  if(_cache != nullptr && !_cache->good()) {
+    std::cerr << "cannot use the action cache in " << _cache->dir() << '\n';
+    ok = false;
+  }
+  else if(_cache != nullptr && ok) {
+    for(const auto& [cell, binary] : _binaries) {
+      _binary_hashes[cell] = ActionCache::digest(binary);
+    }
+  }
+
+  // Tools see an absolute work directory
+  std::error_code ec;
+  std::filesystem::create_directories(_work_dir, ec);
+  if(ec) {
+    std::cerr << "failed to create " << _work_dir << ": " << ec.message() << '\n';
+    ok = false;
+  }
+  else {
+    _work_dir = std::filesystem::absolute(_work_dir);
+  }
+
+  return ok;
+}
+
+// Function: _group
+// Partition the vertices into groups connected by stream wires and count the
+// dependency wires into each group from other groups. The groups must form
+// a DAG under the dependency wires.
+inline bool Executor::_group() {
+
+  const auto V {_graph.num_vertices()};
+  const auto E {_graph.num_edges()};
+
+  constexpr auto NONE {des::CsrGraph::NONE};
+
+  // Union-find rooted at the smallest vertex of each group
+  std::vector<uint32_t> parent(V);
+  std::iota(parent.begin(), parent.end(), 0);
+
+  auto find = [&] (uint32_t v) {
+    while(parent[v] != v) {
+      v = parent[v] = parent[parent[v]];
+    }
+    return v;
+  };
+
+  for(uint32_t e=0; e<E; ++e) {
+    if(_graph.edge_stream[e] && _graph.edge_from[e] != NONE && _graph.edge_to[e] != NONE) {
+      const auto a {find(_graph.edge_from[e])};
+      const auto b {find(_graph.edge_to[e])};
+      parent[std::max(a, b)] = std::min(a, b);
+    }
+  }
+
+  // Number the groups by their smallest vertex and list their members
+  _groups.assign(V, NONE);
+  _group_offsets.assign(1, 0);
+  for(uint32_t v=0; v<V; ++v) {
+    if(auto r = find(v); r == v) {
+      _groups[v] = _group_offsets.size() - 1;
+      _group_offsets.push_back(0);
+    }
+    else {
+      _groups[v] = _groups[r];
+    }
+    ++_group_offsets[_groups[v] + 1];
+  }
+
+  const auto G {num_groups()};
+
+  std::partial_sum(_group_offsets.begin(), _group_offsets.end(), _group_offsets.begin());
+  _members.resize(V);
+  std::vector<uint32_t> cursor(_group_offsets.begin(), _group_offsets.end() - 1);
+  for(uint32_t v=0; v<V; ++v) {
+    _members[cursor[_groups[v]]++] = v;
+  }
+
+  // Dependency wires into each group
+  bool ok {true};
+
+  std::vector<uint32_t> degree(G, 0);
+  for(uint32_t e=0; e<E; ++e) {
+    const auto from {_graph.edge_from[e]};
+    const auto to {_graph.edge_to[e]};
+    if(_graph.edge_stream[e] || from == NONE || to == NONE) {
+      continue;
+    }
+    if(_groups[from] == _groups[to]) {
+      std::cerr << "dependency wire " << render(_graph.edge_names[e]) << " from "
+                << render(_graph.vertex_names[from]) << " to " << render(_graph.vertex_names[to])
+                << " connects cells that stream to each other\n";
+      ok = false;
+    }
+    else {
+      ++degree[_groups[to]];
+    }
+  }
+
+  _pending = std::make_unique<std::atomic<uint32_t>[]>(G);
+  for(uint32_t g=0; g<G; ++g) {
+    _pending[g] = degree[g];
+  }
+
+  // Kahn's algorithm over the groups
+  std::vector<uint32_t> order;
+  order.reserve(G);
+  for(uint32_t g=0; g<G; ++g) {
+    if(degree[g] == 0) order.push_back(g);
+  }
+  for(size_t i=0; i<order.size(); ++i) {
+    for(auto v : _members_of(order[i])) {
+      for(auto e : _graph.fanout_of(v)) {
+        if(auto to = _graph.edge_to[e]; !_graph.edge_stream[e] && to != NONE &&
+           _groups[to] != order[i] && --degree[_groups[to]] == 0) {
+          order.push_back(_groups[to]);
+        }
+      }
+    }
+  }
+
+  if(ok && order.size() != G) {
+    std::cerr << "the flow graph has a cycle\n";
+    ok = false;
+  }
+
+  return ok;
+}
+
+// Function: _join_edges
+inline std::string Executor::_join_edges(des::CsrGraph::Span edges) const {
+  std::string s;
+  for(auto e : edges) {
+    if(!s.empty()) {
+      s.push_back(':');
+    }
+    s += render(_graph.edge_names[e]);
+  }
+  return s;
+}
+
+// Function: _outputs
+// The artifacts of a cell relative to the work directory: those of its
+// outgoing dependency wires, and its log.
+inline std::vector<std::string> Executor::_outputs(uint32_t v) const {
+  std::vector<std::string> outputs;
+  for(auto e : _graph.fanout_of(v)) {
+    if(!_graph.edge_stream[e]) {
+      outputs.push_back(render(_graph.edge_names[e]));
+    }
+  }
+  outputs.push_back(render(_graph.vertex_names[v], '.') + ".log");
+  return outputs;
+}
+
+// Function: _key
+// The action cache key of a cell. The work directory is left out so that a
+// flow run elsewhere hits the same actions.
+inline uint64_t Executor::_key(uint32_t v) const {
+
+  const auto& cell {*_cells[v]};
+
+  std::string key;
+
+  auto field = [&key] (std::string_view s) {
+    key.append(s);
+    key.push_back('\0');
+  };
+
+  field(name_of(cell.name));
+  field(std::to_string(cell.hash));
+  field(_binaries.at(&cell));
+  field(std::to_string(_binary_hashes.at(&cell)));
+  field(render(_graph.vertex_names[v]));
+  field(_join_edges(_graph.fanin_of(v)));
+  field(_join_edges(_graph.fanout_of(v)));
+
+  for(const auto& name : _cache->environment()) {
+    const char* value = std::getenv(name.c_str());
+    field(name);
+    field(value == nullptr ? "\1" : value);
+  }
+
+  for(auto e : _graph.fanin_of(v)) {
+    field(std::to_string(ActionCache::digest(_work_dir / render(_graph.edge_names[e]))));
+  }
+
+  return hash64(key);
+}
+
+// Function: _open
+// Create the pipe or FIFO of a stream wire.
+inline bool Executor::_open(uint32_t e, Channel& c) const {
+
+  const auto wire {render(_graph.edge_names[e])};
+
+  if(_fifos) {
+    c.path = (_work_dir / (render(_graph.edge_names[e], '.') + ".fifo")).string();
+    ::unlink(c.path.c_str());
+    if(::mkfifo(c.path.c_str(), 0600) != 0) {
+      std::cerr << "failed to create FIFO " << c.path << " for " << wire << ": "
+                << std::strerror(errno) << '\n';
+      c.path.clear();
+      return false;
+    }
+  }
+  else if(::pipe2(c.fds, O_CLOEXEC) != 0) {
+    std::cerr << "failed to create a pipe for " << wire << ": " << std::strerror(errno) << '\n';
+    return false;
+  }
+  else {
+    sda::pipe_size(c.fds[0], _pipe_size);
+  }
+
+  if(!_relay && !_tap) {
+    return true;
+  }
+
+  // The producer keeps its end; the relay reads the other and writes into a
+  // second pipe whose read end goes to the consumer
+  int out[2];
+  if(::pipe2(out, O_CLOEXEC) != 0) {
+    std::cerr << "failed to create a pipe for " << wire << ": " << std::strerror(errno) << '\n';
+    return false;
+  }
+  sda::pipe_size(out[0], _pipe_size);
+
+  c.relay[0] = c.fds[0];
+  c.relay[1] = out[1];
+  c.fds[0]   = out[0];
+
+  if(_tap) {
+    const auto log {(_work_dir / (render(_graph.edge_names[e], '.') + ".stream")).string()};
+    if(c.tap = ::open(log.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644); c.tap == -1) {
+      std::cerr << "failed to create " << log << ": " << std::strerror(errno) << '\n';
+      return false;
+    }
+  }
+
+  return true;
+}
+
+// Function: _launch
+// Start the tool of a vertex, given the channels of the stream wires of its
+// group. Returns the process id, or -1 if the tool cannot be launched.
+inline pid_t Executor::_launch(uint32_t v, const std::unordered_map<uint32_t, Channel>& channels) {
+
+  const auto& cell {*_cells[v]};
+
+  const auto& binary {_binaries.at(&cell)};
+  const auto instance {render(_graph.vertex_names[v])};
+  const auto log {(_work_dir / (render(_graph.vertex_names[v], '.') + ".log")).string()};
+
+  // Stream wires: the path of each end and the descriptors the tool inherits
+  std::string stream_inputs, stream_outputs;
+  std::vector<int> inherited;
+
+  auto stream = [&] (std::string& s, uint32_t e, uint32_t peer, int end) {
+    if(!_graph.edge_stream[e]) {
+      return;
+    }
+    if(!s.empty()) {
+      s.push_back(':');
+    }
+    s += render(_graph.edge_names[e]);
+    s.push_back('=');
+    if(peer == des::CsrGraph::NONE) {
+      s += "/dev/null";
+    }
+    else if(const auto& c = channels.at(e); _fifos) {
+      s += c.path;
+    }
+    else {
+      s += "/dev/fd/" + std::to_string(c.fds[end]);
+      inherited.push_back(c.fds[end]);
+    }
+  };
+
+  for(auto e : _graph.fanin_of(v)) {
+    stream(stream_inputs, e, _graph.edge_from[e], 0);
+  }
+  for(auto e : _graph.fanout_of(v)) {
+    stream(stream_outputs, e, _graph.edge_to[e], 1);
+  }
+
+  // Environment: the parent's plus the context of the cell
+  std::vector<std::string> vars {
+    "SDA_CELL=" + std::string(name_of(cell.name)),
+    "SDA_INSTANCE=" + instance,
+    "SDA_WORK_DIR=" + _work_dir.string(),
+    "SDA_INPUTS=" + _join_edges(_graph.fanin_of(v)),
+    "SDA_OUTPUTS=" + _join_edges(_graph.fanout_of(v)),
+    "SDA_STREAM_INPUTS=" + stream_inputs,
+    "SDA_STREAM_OUTPUTS=" + stream_outputs
+  };
+
+  std::vector<char*> envp;
+  for(char** e = environ; *e != nullptr; ++e) {
+    if(std::strncmp(*e, "SDA_", 4) != 0) {
+      envp.push_back(*e);
+    }
+  }
+  for(auto& var : vars) {
+    envp.push_back(var.data());
+  }
+  envp.push_back(nullptr);
+
+  char* argv[] = {const_cast<char*>(binary.c_str()), nullptr};
+
+  pid_t pid {-1};
+  int ret {0};
+
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 29))
+
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  posix_spawn_file_actions_addopen(&actions, STDIN_FILENO, "/dev/null", O_RDONLY, 0);
+  posix_spawn_file_actions_addopen(&actions, STDOUT_FILENO, log.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+  posix_spawn_file_actions_adddup2(&actions, STDOUT_FILENO, STDERR_FILENO);
+  posix_spawn_file_actions_addchdir_np(&actions, _work_dir.c_str());
+
+  // Pipe ends are close-on-exec; a dup2 onto itself clears the flag
+  for(auto fd : inherited) {
+    posix_spawn_file_actions_adddup2(&actions, fd, fd);
+  }
+
+  ret = ::posix_spawn(&pid, binary.c_str(), &actions, nullptr, argv, envp.data());
+
+  posix_spawn_file_actions_destroy(&actions);
+
+#else
+
+  // No chdir action in posix_spawn; only async-signal-safe calls after fork
+  if(pid = ::fork(); pid == 0) {
+    int fd;
+    if(::chdir(_work_dir.c_str()) != 0 ||
+       (fd = ::open("/dev/null", O_RDONLY)) == -1 || ::dup2(fd, STDIN_FILENO) == -1 ||
+       (fd = ::open(log.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644)) == -1 ||
+       ::dup2(fd, STDOUT_FILENO) == -1 || ::dup2(fd, STDERR_FILENO) == -1) {
+      ::_exit(127);
+    }
+    for(auto in : inherited) {
+      if(::fcntl(in, F_SETFD, 0) == -1) {
+        ::_exit(127);
+      }
+    }
+    ::execve(binary.c_str(), argv, envp.data());
+    ::_exit(127);
+  }
+  ret = (pid == -1) ? errno : 0;
+
+#endif
+
+  if(ret != 0) {
+    std::cerr << "failed to launch " << binary << " for " << instance << ": " << std::strerror(ret) << '\n';
+    _states[v] = State::FAILED;
+    return -1;
+  }
+
+  ++_num_launched;
+
+  return pid;
+}
+
+// Function: _reap
+// Record how the tool of a vertex ended, given its wait status or -1 if it
+// could not be waited for. A tool terminated because its group failed is
+// not reported again.
+inline bool Executor::_reap(uint32_t v, int status, bool terminated) {
+
+  const auto& cell {*_cells[v]};
+  const auto instance {render(_graph.vertex_names[v])};
+  const auto log {(_work_dir / (render(_graph.vertex_names[v], '.') + ".log")).string()};
+
+  _states[v] = State::FAILED;
+
+  if(status == -1) {
+    std::cerr << "failed to wait for " << instance << ": " << std::strerror(errno) << '\n';
+    return false;
+  }
+
+  if(!WIFEXITED(status)) {
+    if(!terminated) {
+      std::cerr << instance << " (" << name_of(cell.name) << ") terminated abnormally, see " << log << '\n';
+    }
+    return false;
+  }
+
+  _statuses[v] = WEXITSTATUS(status);
+
+  if(_statuses[v] != 0) {
+    std::cerr << instance << " (" << name_of(cell.name) << ") exited with status "
+              << _statuses[v] << ", see " << log << '\n';
+    return false;
+  }
+
+  _states[v] = State::DONE;
+
+  return true;
+}
+
+// Function: _wait
+// Wait for the tools of a group in the order they exit; a process id of -1
+// was never launched. When one fails the others are terminated, since a
+// stage blocked on a missing peer would otherwise never return. A group of
+// one simply blocks in waitpid.
+inline bool Executor::_wait(des::CsrGraph::Span members, std::vector<pid_t>& pids) {
+
+  bool ok = std::find(pids.begin(), pids.end(), -1) == pids.end();
+  bool terminated {false};
+
+  auto terminate = [&] () {
+    for(auto pid : pids) {
+      if(pid != -1) {
+        ::kill(pid, SIGTERM);
+      }
+    }
+    terminated = true;
+  };
+
+  if(!ok) {
+    terminate();
+  }
+
+  size_t running = pids.size() - std::count(pids.begin(), pids.end(), -1);
+
+  std::chrono::microseconds delay {100};
+
+  while(running > 0) {
+
+    bool reaped {false};
+
+    for(size_t i=0; i<pids.size(); ++i) {
+
+      if(pids[i] == -1) {
+        continue;
+      }
+
+      int status {0};
+      pid_t ret = ::waitpid(pids[i], &status, running == 1 ? 0 : WNOHANG);
+
+      if(ret == 0 || (ret == -1 && errno == EINTR)) {
+        continue;
+      }
+
+      pids[i] = -1;
+      --running;
+      reaped = true;
+
+      if(!_reap(members.first[i], ret == -1 ? -1 : status, terminated)) {
+        ok = false;
+        if(!terminated) {
+          terminate();
+        }
+      }
+    }
+
+    if(reaped) {
+      delay = std::chrono::microseconds(100);
+    }
+    else if(running > 0) {
+      std::this_thread::sleep_for(delay);
+      delay = std::min<std::chrono::microseconds>(delay * 2, std::chrono::milliseconds(10));
+    }
+  }
+
+  return ok;
+}
+
+// Function: _run
+// Run the tools of a group to completion. The stream wires between them are
+// created first and the parent closes its copies once every tool is
+// launched, so a reader sees end of file when its writer exits.
+inline bool Executor::_run(uint32_t g) {
+
+  const auto members {_members_of(g)};
+
+  bool ok {true};
+
+  std::error_code ec;
+
+  // A lone cell may be restored from the cache; streams leave no artifact,
+  // so cells that stream always run
+  const bool cached = _cache != nullptr && members.size() == 1 && [&] () {
+    const auto v {members.first[0]};
+    auto stream = [&] (uint32_t e) { return _graph.edge_stream[e]; };
+    return std::none_of(_graph.fanin_of(v).begin(), _graph.fanin_of(v).end(), stream) &&
+           std::none_of(_graph.fanout_of(v).begin(), _graph.fanout_of(v).end(), stream);
+  }();
+
+  uint64_t key {0};
+  std::vector<std::string> outputs;
+
+  if(cached) {
+    const auto v {members.first[0]};
+    key = _key(v);
+    outputs = _outputs(v);
+    for(const auto& output : outputs) {
+      std::filesystem::remove_all(_work_dir / output, ec);
+    }
+    if(_cache->restore(key, _work_dir)) {
+      _states[v] = State::CACHED;
+      _statuses[v] = 0;
+      ++_num_cached;
+      return true;
+    }
+  }
+
+  // Tools write their outputs into existing directories
+  for(auto v : members) {
+    for(auto e : _graph.fanout_of(v)) {
+      if(!_graph.edge_stream[e]) {
+        std::filesystem::create_directories((_work_dir / render(_graph.edge_names[e])).parent_path(), ec);
+      }
+    }
+  }
+
+  // Stream wire inside the group -> channel
+  std::unordered_map<uint32_t, Channel> channels;
+
+  for(auto v : members) {
+    for(auto e : _graph.fanout_of(v)) {
+      if(_graph.edge_stream[e] && _graph.edge_to[e] != des::CsrGraph::NONE) {
+        if(!_open(e, channels[e])) {
+          ok = false;
+        }
+      }
+    }
+  }
+
+  // Without its streams no tool of the group can run
+  if(!ok) {
+    for(auto v : members) {
+      _states[v] = State::FAILED;
+    }
+  }
+
+  std::vector<pid_t> pids(members.size(), -1);
+
+  for(size_t i=0; i<members.size() && ok; ++i) {
+    pids[i] = _launch(members.first[i], channels);
+    ok = (pids[i] != -1);
+  }
+
+  for(auto& [e, c] : channels) {
+    for(auto fd : c.fds) {
+      if(fd != -1) {
+        ::close(fd);
+      }
+    }
+  }
+
+  // Relays close their ends as they finish, which passes end of file on to
+  // the consumer and a broken pipe back to the producer
+  std::vector<std::thread> relays;
+
+  for(auto& [e, c] : channels) {
+    if(c.relay[0] == -1) {
+      continue;
+    }
+    auto finish = [c] () {
+      for(auto fd : {c.relay[0], c.relay[1], c.tap}) {
+        if(fd != -1) {
+          ::close(fd);
+        }
+      }
+    };
+    if(!ok) {
+      finish();
+      continue;
+    }
+    relays.emplace_back([this, e=e, c=c, finish] () {
+      Relay(c.relay[0], c.relay[1], c.tap).run(_relay_stats[e]);
+      finish();
+    });
+  }
+
+  ok = _wait(members, pids) && ok;
+
+  for(auto& relay : relays) {
+    relay.join();
+  }
+
+  for(auto& [e, c] : channels) {
+    if(!c.path.empty()) {
+      ::unlink(c.path.c_str());
+    }
+  }
+
+  if(ok && cached && !_cache->store(key, _work_dir, outputs)) {
+    std::cerr << "failed to cache the outputs of " << render(_graph.vertex_names[members.first[0]]) << '\n';
+  }
+
+  return ok;
+}
+
+// Function: run
+// Run the whole graph. Returns false if the graph cannot run or any tool
+// fails; the state of each vertex tells what ran.
+inline bool Executor::run() {
+
+  if(!_prepare()) {
+    return false;
+  }
+
+  const auto G {num_groups()};
+
+  std::atomic<bool> ok {true};
+
+  Threadpool pool(_num_workers);
+
+  std::function<void(uint32_t)> task = [&] (uint32_t g) {
+    if(!_run(g)) {
+      ok = false;
+      return;
+    }
+    for(auto v : _members_of(g)) {
+      for(auto e : _graph.fanout_of(v)) {
+        if(auto to = _graph.edge_to[e]; !_graph.edge_stream[e] && to != des::CsrGraph::NONE &&
+           --_pending[_groups[to]] == 0) {
+          pool.silent_async([&task, to=_groups[to]] () { task(to); });
+        }
+      }
+    }
+  };
+
+  // Find the sources before starting any, since a task that finishes right
+  // away releases its successors
+  std::vector<uint32_t> sources;
+  for(uint32_t g=0; g<G; ++g) {
+    if(_pending[g] == 0) {
+      sources.push_back(g);
+    }
+  }
+
+  for(auto g : sources) {
+    pool.silent_async([&task, g] () { task(g); });
+  }
+
+  pool.wait_for_all();
+
+  // Whatever is left waits on a failed cell
+  for(auto& s : _states) {
+    if(s == State::PENDING) {
+      s = State::SKIPPED;
+    }
+  }
+
+  return ok;
+}
+
+
+};  // end of namespace sda. ----------------------------------------------------------------------
+
+#endif
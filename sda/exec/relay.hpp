@@ -0,0 +1,230 @@
+#ifndef SDA_EXEC_RELAY_HPP_
+#define SDA_EXEC_RELAY_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <chrono>
+#include <csignal>
+#include <cstdint>
+#include <fcntl.h>
+#include <poll.h>
+#include <pthread.h>
+#include <unistd.h>
+
+namespace sda {
+
+// Function: pipe_size
+// Resize the buffer of a pipe with F_SETPIPE_SZ and return its size. The
+// kernel rounds the size up to a power-of-two number of pages and refuses
+// sizes over /proc/sys/fs/pipe-max-size or the per-user quota to
+// unprivileged users, in which case the buffer keeps its size.
+inline size_t pipe_size(int fd, size_t bytes) {
+  if(bytes != 0) {
+    ::fcntl(fd, F_SETPIPE_SZ, static_cast<int>(bytes));
+  }
+  const int size = ::fcntl(fd, F_GETPIPE_SZ);
+  return size < 0 ? 0 : size;
+}
+
+// Struct: RelayStats
+// Traffic of a relay. Counters are updated while the relay runs and may be
+// read concurrently. Time waiting for the consumer to drain its pipe is
+// backpressure; time waiting for the producer to fill its pipe is idle.
+struct RelayStats {
+  std::atomic<uint64_t> bytes {0};
+  std::atomic<uint64_t> splices {0};
+  std::atomic<uint64_t> stalls {0};
+  std::atomic<uint64_t> stalled_ns {0};
+  std::atomic<uint64_t> idle_ns {0};
+  std::atomic<uint64_t> elapsed_ns {0};
+
+  double throughput() const;
+};
+
+// Function: throughput
+// Bytes per second over the life of the relay.
+inline double RelayStats::throughput() const {
+  const auto ns = elapsed_ns.load();
+  return ns == 0 ? 0.0 : bytes.load() * 1e9 / ns;
+}
+
+// Class: Relay
+// Move a stream from one pipe to another inside the kernel with splice(2),
+// so the data never crosses into user space. With a tap, the data is first
+// duplicated into the output with tee(2) and then spliced into the tap, a
+// log file or another pipe. The relay runs until the producer closes its end
+// (true), or until either side fails, e.g., the consumer goes away (false).
+// It does not own the descriptors.
+//
+// Pipe operations are nonblocking, so a relay knows which side holds it up:
+// a full output counts as a stall, an empty input as idle time. SIGPIPE is
+// blocked in the calling thread while the relay runs; a closed consumer is
+// seen as EPIPE.
+class Relay {
+
+  public:
+
+    Relay(int, int, int = -1);
+
+    bool run(RelayStats&, size_t = 1 << 20);
+
+  private:
+
+    int _in;
+    int _out;
+    int _tap;
+
+    bool _poll(int, short, std::atomic<uint64_t>&);
+    bool _drain(size_t);
+};
+
+// Constructor
+// Relay from the pipe in to the pipe out, copying to tap if it is open.
+inline Relay::Relay(int in, int out, int tap) :
+  _in {in}, _out {out}, _tap {tap} {
+}
+
+// Function: _poll
+// Wait until the descriptor is ready, adding the time waited to the counter.
+inline bool Relay::_poll(int fd, short events, std::atomic<uint64_t>& ns) {
+
+  struct pollfd p {fd, events, 0};
+
+  auto beg = std::chrono::steady_clock::now();
+
+  int ret;
+  while((ret = ::poll(&p, 1, -1)) == -1 && errno == EINTR);
+
+  auto end = std::chrono::steady_clock::now();
+
+  ns += std::chrono::duration_cast<std::chrono::nanoseconds>(end - beg).count();
+
+  return ret == 1;
+}
+
+// Function: _drain
+// Move n bytes, already duplicated to the output, from the input to the tap.
+// splice(2) cannot write to every file, so the tap falls back to a copy.
+inline bool Relay::_drain(size_t n) {
+
+  while(n > 0) {
+
+    auto ret = ::splice(_in, nullptr, _tap, nullptr, n, SPLICE_F_MOVE);
+
+    if(ret > 0) {
+      n -= ret;
+      continue;
+    }
+    if(ret == -1 && errno == EINTR) {
+      continue;
+    }
+    if(ret == 0 || errno != EINVAL) {
+      return false;
+    }
+
+    char buf[1 << 16];
+    auto r = ::read(_in, buf, std::min(n, sizeof(buf)));
+    if(r <= 0) {
+      if(r == -1 && errno == EINTR) {
+        continue;
+      }
+      return false;
+    }
+    for(ssize_t w=0; w<r; ) {
+      auto k = ::write(_tap, buf + w, r - w);
+      if(k == -1) {
+        if(errno == EINTR) {
+          continue;
+        }
+        return false;
+      }
+      w += k;
+    }
+    n -= r;
+  }
+
+  return true;
+}
+
+// Function: run
+// Relay the stream to the end, at most chunk bytes per call.
+inline bool Relay::run(RelayStats& stats, size_t chunk) {
+
+  sigset_t pipe, old;
+  sigemptyset(&pipe);
+  sigaddset(&pipe, SIGPIPE);
+  pthread_sigmask(SIG_BLOCK, &pipe, &old);
+
+  auto beg = std::chrono::steady_clock::now();
+
+  bool ok {true};
+
+  while(true) {
+
+    auto ret = (_tap == -1) ?
+      ::splice(_in, nullptr, _out, nullptr, chunk, SPLICE_F_MOVE | SPLICE_F_NONBLOCK) :
+      ::tee(_in, _out, chunk, SPLICE_F_NONBLOCK);
+
+    if(ret > 0) {
+      ++stats.splices;
+      if(_tap != -1 && !_drain(ret)) {
+        ok = false;
+        break;
+      }
+      stats.bytes += ret;
+      continue;
+    }
+
+    if(ret == 0) {
+      break;
+    }
+
+    if(errno == EINTR) {
+      continue;
+    }
+
+    if(errno != EAGAIN) {
+      ok = false;
+      break;
+    }
+
+    // Find the side that is not ready: an empty input, or else a full output
+    struct pollfd p[2] {{_in, POLLIN, 0}, {_out, POLLOUT, 0}};
+    ::poll(p, 2, 0);
+
+    if(!(p[0].revents & (POLLIN | POLLHUP))) {
+      if(!_poll(_in, POLLIN, stats.idle_ns)) {
+        ok = false;
+        break;
+      }
+    }
+    else if(!(p[1].revents & POLLOUT)) {
+      if(p[1].revents & (POLLERR | POLLHUP)) {
+        ok = false;
+        break;
+      }
+      ++stats.stalls;
+      if(!_poll(_out, POLLOUT, stats.stalled_ns)) {
+        ok = false;
+        break;
+      }
+    }
+  }
+
+  auto end = std::chrono::steady_clock::now();
+
+  stats.elapsed_ns += std::chrono::duration_cast<std::chrono::nanoseconds>(end - beg).count();
+
+  // Consume a SIGPIPE raised by a closed consumer before unblocking it
+  struct timespec zero {0, 0};
+  while(::sigtimedwait(&pipe, nullptr, &zero) == SIGPIPE);
+  pthread_sigmask(SIG_SETMASK, &old, nullptr);
+
+  return ok;
+}
+
+
+};  // end of namespace sda. ----------------------------------------------------------------------
+
+#endif
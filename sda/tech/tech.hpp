@@ -0,0 +1,608 @@
+#ifndef SDA_TECH_TECH_HPP_
+#define SDA_TECH_TECH_HPP_
+
+#include <algorithm>
+#include <cstdint>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <experimental/filesystem>
+#include <sda/utility/hash.hpp>
+#include <sda/utility/mmap.hpp>
+#include <sda/utility/symbol.hpp>
+#include <sda/utility/threadpool.hpp>
+
+namespace std {
+  namespace filesystem = experimental::filesystem;
+};
+
+namespace sda {
+
+// Struct: TechPin
+struct TechPin {
+
+  enum class Direction : uint8_t {
+    IN = 0,
+    OUT,
+    INOUT
+  };
+
+  enum class Type : uint8_t {
+    DEPENDENCY = 0,
+    STREAM
+  };
+
+  Symbol name {EMPTY_SYMBOL};
+  Direction direction {Direction::IN};
+  Type type {Type::DEPENDENCY};
+};
+
+// Struct: TechCell
+// A cell described by a .tech file: the tool binary that implements it, its
+// pins, and how to prepare the tool. The binary is as written in the file,
+// relative to the directory of the file unless absolute. The hash is that of
+// the whole .tech file, so it changes with any part of the description.
+struct TechCell {
+
+  Symbol name {EMPTY_SYMBOL};
+
+  std::string binary;
+  std::filesystem::path directory;
+  uint64_t hash {0};
+
+  std::vector<TechPin> pins;
+
+  // prepare section
+  std::string os;
+  std::string compiler;
+  std::string version;
+  std::vector<std::string> dependency;
+  std::vector<std::string> build;
+
+  const TechPin* pin(Symbol) const;
+};
+
+// Function: pin
+// Return the pin of the given name, or nullptr. Cells have few pins.
+inline const TechPin* TechCell::pin(Symbol name) const {
+  for(const auto& p : pins) {
+    if(p.name == name) {
+      return &p;
+    }
+  }
+  return nullptr;
+}
+
+// ------------------------------------------------------------------------------------------------
+
+// Class: TechParser
+// Single-pass parser of the YAML subset used by .tech files:
+//
+//   ---
+//   prepare:
+//     - os: ubuntu
+//     - build:
+//         - make
+//   cell:
+//     - name: PR
+//     - binary: hello
+//     - pin:
+//         name: i
+//         direction: in
+//         type: dependency
+//   ...
+//
+// Each "cell:" section describes one cell and takes the nearest "prepare:"
+// section before it in the same document. Items of unknown keys are skipped
+// along with their nested lines, so newer files still load. Comments start
+// with '#' at the beginning of a line or after a space.
+class TechParser {
+
+  public:
+
+    TechParser(std::string_view, const std::filesystem::path&);
+
+    bool parse(std::vector<TechCell>&);
+
+    const std::string& error() const;
+
+  private:
+
+    enum class Section : uint8_t {
+      NONE = 0,
+      PREPARE,
+      CELL
+    };
+
+    enum class Nested : uint8_t {
+      NONE = 0,
+      SKIP,
+      DEPENDENCY,
+      BUILD,
+      PIN
+    };
+
+    std::string_view _buffer;
+    std::filesystem::path _path;
+    uint64_t _hash {0};
+
+    size_t _line_no {0};
+    std::string _error;
+
+    Section _section {Section::NONE};
+    Nested _nested {Nested::NONE};
+
+    // indentation of the items of the section, npos until the first item
+    size_t _item_indent {std::string_view::npos};
+
+    TechCell _prepare;
+    TechCell _cell;
+
+    bool _fail(std::string_view);
+    bool _item(std::string_view, std::string_view);
+    bool _nested_line(std::string_view);
+    bool _pin_field(std::string_view, std::string_view);
+    bool _end_cell(std::vector<TechCell>&);
+
+    static bool _key_value(std::string_view, std::string_view&, std::string_view&);
+    static std::string_view _trim(std::string_view);
+};
+
+// Constructor
+inline TechParser::TechParser(std::string_view buffer, const std::filesystem::path& path) :
+  _buffer {buffer}, _path {path}, _hash {hash64(buffer)} {
+}
+
+// Function: error
+inline const std::string& TechParser::error() const {
+  return _error;
+}
+
+// Function: _fail
+inline bool TechParser::_fail(std::string_view what) {
+  _error = _path.string() + ':' + std::to_string(_line_no) + ": " + std::string(what);
+  return false;
+}
+
+// Function: _trim
+inline std::string_view TechParser::_trim(std::string_view s) {
+  const auto b = s.find_first_not_of(" \t\r");
+  if(b == std::string_view::npos) {
+    return {};
+  }
+  return s.substr(b, s.find_last_not_of(" \t\r") - b + 1);
+}
+
+// Function: _key_value
+// Split "key: value" or "key:"; the value may be empty.
+inline bool TechParser::_key_value(std::string_view s, std::string_view& key, std::string_view& value) {
+  const auto colon = s.find(':');
+  if(colon == std::string_view::npos || colon == 0) {
+    return false;
+  }
+  key = _trim(s.substr(0, colon));
+  value = _trim(s.substr(colon + 1));
+  return !key.empty();
+}
+
+// Function: parse
+// Append the cells of the buffer. Returns false on the first error, which is
+// kept in error().
+inline bool TechParser::parse(std::vector<TechCell>& cells) {
+
+  for(size_t beg = 0; beg < _buffer.size(); ) {
+
+    auto end = _buffer.find('\n', beg);
+    if(end == std::string_view::npos) {
+      end = _buffer.size();
+    }
+    auto line = _buffer.substr(beg, end - beg);
+    beg = end + 1;
+    ++_line_no;
+
+    // Strip the comment
+    for(size_t i = line.find('#'); i != std::string_view::npos; i = line.find('#', i + 1)) {
+      if(i == 0 || line[i-1] == ' ' || line[i-1] == '\t') {
+        line = line.substr(0, i);
+        break;
+      }
+    }
+
+    const auto indent = line.find_first_not_of(' ');
+    if(indent == std::string_view::npos || _trim(line).empty()) {
+      continue;
+    }
+    if(line[indent] == '\t') {
+      return _fail("tabs are not allowed for indentation");
+    }
+    line = _trim(line);
+
+    const bool is_item = line.size() >= 2 && line[0] == '-' && line[1] == ' ';
+
+    // Document markers end the current cell
+    if(indent == 0 && (line == "---" || line == "...")) {
+      if(!_end_cell(cells)) {
+        return false;
+      }
+      _section = Section::NONE;
+      if(line == "---") {
+        _prepare = TechCell();
+      }
+      continue;
+    }
+
+    // Section
+    if(indent == 0 && !is_item) {
+      std::string_view key, value;
+      if(!_key_value(line, key, value) || !value.empty()) {
+        return _fail("expected a section");
+      }
+      if(!_end_cell(cells)) {
+        return false;
+      }
+      if(key == "prepare") {
+        _section = Section::PREPARE;
+      }
+      else if(key == "cell") {
+        _section = Section::CELL;
+        _cell = _prepare;
+      }
+      else {
+        _section = Section::NONE;
+      }
+      _nested = Nested::SKIP;
+      _item_indent = std::string_view::npos;
+      continue;
+    }
+
+    // Lines of an unknown section
+    if(_section == Section::NONE) {
+      continue;
+    }
+
+    // The first item of a section sets the indentation of its items
+    if(is_item && (_item_indent == std::string_view::npos || indent == _item_indent)) {
+      _item_indent = indent;
+      std::string_view key, value;
+      if(!_key_value(_trim(line.substr(2)), key, value)) {
+        return _fail("expected a key");
+      }
+      if(!_item(key, value)) {
+        return false;
+      }
+    }
+    else if(_item_indent != std::string_view::npos && indent > _item_indent) {
+      if(!_nested_line(line)) {
+        return false;
+      }
+    }
+    else {
+      return _fail("unexpected indentation");
+    }
+  }
+
+  return _end_cell(cells);
+}
+
+// Function: _item
+// Handle an item "- key: value" or "- key:" of the current section.
+inline bool TechParser::_item(std::string_view key, std::string_view value) {
+
+  auto& cell = (_section == Section::PREPARE) ? _prepare : _cell;
+
+  _nested = Nested::SKIP;
+
+  if(key == "os") {
+    cell.os = value;
+  }
+  else if(key == "compiler") {
+    cell.compiler = value;
+  }
+  else if(key == "version") {
+    cell.version = value;
+  }
+  else if(key == "dependency" || key == "build") {
+    auto& list = (key == "build") ? cell.build : cell.dependency;
+    list.clear();
+    if(!value.empty()) {
+      list.emplace_back(value);
+    }
+    _nested = (key == "build") ? Nested::BUILD : Nested::DEPENDENCY;
+  }
+  else if(_section == Section::CELL && key == "name") {
+    if(value.empty()) {
+      return _fail("empty cell name");
+    }
+    _cell.name = intern(value);
+  }
+  else if(_section == Section::CELL && key == "binary") {
+    _cell.binary = value;
+  }
+  else if(_section == Section::CELL && key == "pin") {
+    if(!value.empty()) {
+      return _fail("expected the fields of the pin on the next lines");
+    }
+    _cell.pins.emplace_back();
+    _nested = Nested::PIN;
+  }
+
+  return true;
+}
+
+// Function: _nested_line
+// Handle a line nested under an item: a list entry or a pin field.
+inline bool TechParser::_nested_line(std::string_view line) {
+
+  auto& cell = (_section == Section::PREPARE) ? _prepare : _cell;
+
+  switch(_nested) {
+
+    case Nested::DEPENDENCY:
+    case Nested::BUILD:
+      if(line.size() < 2 || line[0] != '-' || line[1] != ' ') {
+        return _fail("expected a list entry");
+      }
+      (_nested == Nested::BUILD ? cell.build : cell.dependency).emplace_back(_trim(line.substr(2)));
+      return true;
+
+    case Nested::PIN: {
+      std::string_view key, value;
+      if(!_key_value(line, key, value)) {
+        return _fail("expected a pin field");
+      }
+      return _pin_field(key, value);
+    }
+
+    case Nested::SKIP:
+      return true;
+
+    default:
+      return _fail("unexpected line");
+  }
+}
+
+// Function: _pin_field
+inline bool TechParser::_pin_field(std::string_view key, std::string_view value) {
+
+  auto& pin = _cell.pins.back();
+
+  if(key == "name") {
+    if(value.empty()) {
+      return _fail("empty pin name");
+    }
+    pin.name = intern(value);
+  }
+  else if(key == "direction") {
+    if(value == "in" || value == "input") {
+      pin.direction = TechPin::Direction::IN;
+    }
+    else if(value == "out" || value == "output") {
+      pin.direction = TechPin::Direction::OUT;
+    }
+    else if(value == "inout") {
+      pin.direction = TechPin::Direction::INOUT;
+    }
+    else {
+      return _fail("unknown pin direction '" + std::string(value) + '\'');
+    }
+  }
+  else if(key == "type") {
+    if(value == "dependency") {
+      pin.type = TechPin::Type::DEPENDENCY;
+    }
+    else if(value == "stream") {
+      pin.type = TechPin::Type::STREAM;
+    }
+    else {
+      return _fail("unknown pin type '" + std::string(value) + '\'');
+    }
+  }
+
+  return true;
+}
+
+// Function: _end_cell
+// Validate and commit the cell being parsed, if any.
+inline bool TechParser::_end_cell(std::vector<TechCell>& cells) {
+
+  if(_section != Section::CELL) {
+    return true;
+  }
+
+  _section = Section::NONE;
+
+  if(_cell.name == EMPTY_SYMBOL) {
+    return _fail("cell without a name");
+  }
+
+  for(size_t i=0; i<_cell.pins.size(); ++i) {
+    if(_cell.pins[i].name == EMPTY_SYMBOL) {
+      return _fail("pin without a name in cell " + std::string(name_of(_cell.name)));
+    }
+    for(size_t j=0; j<i; ++j) {
+      if(_cell.pins[i].name == _cell.pins[j].name) {
+        return _fail("duplicate pin " + std::string(name_of(_cell.pins[i].name)) +
+                     " in cell " + std::string(name_of(_cell.name)));
+      }
+    }
+  }
+
+  _cell.directory = _path.parent_path();
+  _cell.hash = _hash;
+
+  cells.push_back(std::move(_cell));
+  _cell = TechCell();
+
+  return true;
+}
+
+// ------------------------------------------------------------------------------------------------
+
+// Class: TechLibrary
+// Registry of tech cells. Cells are found in constant time by name through a
+// table indexed directly by symbol, since symbols are dense. Cells are kept
+// in load order. Errors are reported on std::cerr.
+class TechLibrary {
+
+  public:
+
+    static constexpr uint32_t NONE {std::numeric_limits<uint32_t>::max()};
+
+    bool parse(std::string_view, const std::filesystem::path& = "");
+
+    bool load(const std::filesystem::path&, unsigned = std::thread::hardware_concurrency());
+
+    const TechCell* find(Symbol) const;
+    const TechCell* find(std::string_view) const;
+
+    const std::vector<TechCell>& cells() const;
+
+    size_t size() const;
+    bool empty() const;
+
+    void clear();
+
+  private:
+
+    std::vector<TechCell> _cells;
+
+    // symbol -> cell index
+    std::vector<uint32_t> _index;
+
+    bool _insert(std::vector<TechCell>&&, const std::filesystem::path&);
+};
+
+// Function: cells
+inline const std::vector<TechCell>& TechLibrary::cells() const {
+  return _cells;
+}
+
+// Function: size
+inline size_t TechLibrary::size() const {
+  return _cells.size();
+}
+
+// Function: empty
+inline bool TechLibrary::empty() const {
+  return _cells.empty();
+}
+
+// Procedure: clear
+inline void TechLibrary::clear() {
+  _cells.clear();
+  _index.clear();
+}
+
+// Function: find
+inline const TechCell* TechLibrary::find(Symbol name) const {
+  if(name >= _index.size() || _index[name] == NONE) {
+    return nullptr;
+  }
+  return &_cells[_index[name]];
+}
+
+// Function: find
+// Names that were never seen are not interned.
+inline const TechCell* TechLibrary::find(std::string_view name) const {
+  if(!SymbolTable::get().contains(name)) {
+    return nullptr;
+  }
+  return find(intern(name));
+}
+
+// Function: _insert
+// Register parsed cells. A cell already registered is reported and skipped.
+inline bool TechLibrary::_insert(std::vector<TechCell>&& cells, const std::filesystem::path& path) {
+
+  bool ok {true};
+
+  for(auto& cell : cells) {
+    if(cell.name >= _index.size()) {
+      _index.resize(std::max<size_t>(cell.name + 1, 2 * _index.size()), NONE);
+    }
+    if(_index[cell.name] != NONE) {
+      std::cerr << path.string() << ": duplicate cell " << name_of(cell.name) << '\n';
+      ok = false;
+      continue;
+    }
+    _index[cell.name] = static_cast<uint32_t>(_cells.size());
+    _cells.push_back(std::move(cell));
+  }
+
+  return ok;
+}
+
+// Function: parse
+// Parse the cells of an in-memory .tech description. The path locates the
+// binaries and names the source in error messages.
+inline bool TechLibrary::parse(std::string_view buffer, const std::filesystem::path& path) {
+
+  std::vector<TechCell> cells;
+  TechParser parser(buffer, path);
+
+  if(!parser.parse(cells)) {
+    std::cerr << parser.error() << '\n';
+    return false;
+  }
+
+  return _insert(std::move(cells), path);
+}
+
+// Function: load
+// Load a .tech file, or every .tech file under a directory tree. Files are
+// parsed in parallel and registered in path order, so the result, including
+// which of two duplicate cells wins, does not depend on the number of
+// threads. Returns false if any file fails, but keeps the cells of the others.
+inline bool TechLibrary::load(const std::filesystem::path& path, unsigned num_threads) {
+
+  std::vector<std::filesystem::path> files;
+
+  if(std::filesystem::is_directory(path)) {
+    for(const auto& entry : std::filesystem::recursive_directory_iterator(path)) {
+      if(entry.path().extension() == ".tech" && std::filesystem::is_regular_file(entry.path())) {
+        files.push_back(entry.path());
+      }
+    }
+    std::sort(files.begin(), files.end());
+  }
+  else {
+    files.push_back(path);
+  }
+
+  std::vector<std::vector<TechCell>> cells(files.size());
+  std::vector<std::string> errors(files.size());
+
+  parallel_for(files.size(), num_threads, [&] (size_t i) {
+    MappedFile file;
+    if(!file.open(files[i])) {
+      errors[i] = "failed to open " + files[i].string();
+      return;
+    }
+    TechParser parser(file.view(), files[i]);
+    if(!parser.parse(cells[i])) {
+      errors[i] = parser.error();
+    }
+  });
+
+  bool ok {true};
+
+  for(size_t i=0; i<files.size(); ++i) {
+    if(!errors[i].empty()) {
+      std::cerr << errors[i] << '\n';
+      ok = false;
+    }
+    else if(!_insert(std::move(cells[i]), files[i])) {
+      ok = false;
+    }
+  }
+
+  return ok;
+}
+
+
+};  // end of namespace sda. ----------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,111 @@
+#ifndef SDA_UTILITY_HASH_HPP_
+#define SDA_UTILITY_HASH_HPP_
+
+#include <cstdint>
+#include <cstring>
+#include <string_view>
+
+namespace sda {
+
+// Fast non-cryptographic 64-bit hash of a byte range (the XXH64 algorithm).
+// Used to detect changed file contents and to key cached artifacts; it is
+// not meant to resist adversarial inputs.
+
+namespace hash_detail {
+
+inline constexpr uint64_t P1 {0x9E3779B185EBCA87ULL};
+inline constexpr uint64_t P2 {0xC2B2AE3D27D4EB4FULL};
+inline constexpr uint64_t P3 {0x165667B19E3779F9ULL};
+inline constexpr uint64_t P4 {0x85EBCA77C2B2AE63ULL};
+inline constexpr uint64_t P5 {0x27D4EB2F165667C5ULL};
+
+inline uint64_t rotl(uint64_t x, int r) {
+  return (x << r) | (x >> (64 - r));
+}
+
+inline uint64_t read64(const unsigned char* p) {
+  uint64_t v;
+  std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+inline uint32_t read32(const unsigned char* p) {
+  uint32_t v;
+  std::memcpy(&v, p, sizeof(v));
+  return v;
+}
+
+inline uint64_t round(uint64_t acc, uint64_t input) {
+  return rotl(acc + input * P2, 31) * P1;
+}
+
+inline uint64_t merge(uint64_t acc, uint64_t v) {
+  return (acc ^ round(0, v)) * P1 + P4;
+}
+
+};  // end of namespace hash_detail. ---------------------------------------------------------------
+
+// Function: hash64
+inline uint64_t hash64(const void* data, size_t len, uint64_t seed = 0) {
+
+  using namespace hash_detail;
+
+  auto p = static_cast<const unsigned char*>(data);
+  const auto end = p + len;
+
+  uint64_t h;
+
+  if(len >= 32) {
+    uint64_t v1 = seed + P1 + P2;
+    uint64_t v2 = seed + P2;
+    uint64_t v3 = seed;
+    uint64_t v4 = seed - P1;
+    for(const auto limit = end - 32; p <= limit; p += 32) {
+      v1 = round(v1, read64(p));
+      v2 = round(v2, read64(p + 8));
+      v3 = round(v3, read64(p + 16));
+      v4 = round(v4, read64(p + 24));
+    }
+    h = rotl(v1, 1) + rotl(v2, 7) + rotl(v3, 12) + rotl(v4, 18);
+    h = merge(h, v1);
+    h = merge(h, v2);
+    h = merge(h, v3);
+    h = merge(h, v4);
+  }
+  else {
+    h = seed + P5;
+  }
+
+  h += len;
+
+  for(; p + 8 <= end; p += 8) {
+    h = rotl(h ^ round(0, read64(p)), 27) * P1 + P4;
+  }
+
+  if(p + 4 <= end) {
+    h = rotl(h ^ (read32(p) * P1), 23) * P2 + P3;
+    p += 4;
+  }
+
+  for(; p < end; ++p) {
+    h = rotl(h ^ (*p * P5), 11) * P1;
+  }
+
+  h ^= h >> 33;
+  h *= P2;
+  h ^= h >> 29;
+  h *= P3;
+  h ^= h >> 32;
+
+  return h;
+}
+
+// Function: hash64
+inline uint64_t hash64(std::string_view s, uint64_t seed = 0) {
+  return hash64(s.data(), s.size(), seed);
+}
+
+
+};  // end of namespace sda. ----------------------------------------------------------------------
+
+#endif
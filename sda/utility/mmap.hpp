@@ -0,0 +1,217 @@
+#ifndef SDA_UTILITY_MMAP_HPP_
+#define SDA_UTILITY_MMAP_HPP_
+
+#include <string>
+#include <cerrno>
+#include <string_view>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <experimental/filesystem>
+
+namespace std {
+  namespace filesystem = experimental::filesystem;
+};
+
+namespace sda {
+
+// Class: MappedFile
+// Read-only view of the content of a file. Regular files are memory-mapped so
+// the content is never copied into the heap. Pipes, character devices and the
+// standard input (path "-") cannot be mapped and are streamed into an owned
+// buffer instead. Views returned by the object stay valid until it is closed.
+class MappedFile {
+
+  public:
+
+    MappedFile() = default;
+    MappedFile(const std::filesystem::path&);
+    ~MappedFile();
+
+    MappedFile(MappedFile&&);
+    MappedFile& operator = (MappedFile&&);
+
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator = (const MappedFile&) = delete;
+
+    bool open(const std::filesystem::path&);
+    void close();
+
+    bool good() const;
+    bool is_mapped() const;
+
+    const char* data() const;
+    size_t size() const;
+    std::string_view view() const;
+
+  private:
+
+    const char* _data {nullptr};
+    size_t _size {0};
+    bool _good {false};
+    bool _mapped {false};
+    std::string _buffer;
+
+    bool _stream(int);
+};
+
+// Constructor
+inline MappedFile::MappedFile(const std::filesystem::path& path) {
+  open(path);
+}
+
+// Destructor
+inline MappedFile::~MappedFile() {
+  close();
+}
+
+// Move constructor
+inline MappedFile::MappedFile(MappedFile&& rhs) {
+  *this = std::move(rhs);
+}
+
+// Move assignment
+inline MappedFile& MappedFile::operator = (MappedFile&& rhs) {
+  if(this != &rhs) {
+    close();
+    _buffer = std::move(rhs._buffer);
+    _data   = rhs._mapped ? rhs._data : _buffer.data();
+    _size   = rhs._size;
+    _good   = rhs._good;
+    _mapped = rhs._mapped;
+    rhs._data   = nullptr;
+    rhs._size   = 0;
+    rhs._good   = false;
+    rhs._mapped = false;
+  }
+  return *this;
+}
+
+// Function: good
+inline bool MappedFile::good() const {
+  return _good;
+}
+
+// Function: is_mapped
+inline bool MappedFile::is_mapped() const {
+  return _mapped;
+}
+
+// Function: data
+inline const char* MappedFile::data() const {
+  return _data;
+}
+
+// Function: size
+inline size_t MappedFile::size() const {
+  return _size;
+}
+
+// Function: view
+inline std::string_view MappedFile::view() const {
+  return {_data, _size};
+}
+
+// Function: open
+// Map a regular file or stream a non-seekable one. Returns false if the file
+// cannot be opened or read.
+inline bool MappedFile::open(const std::filesystem::path& path) {
+
+  close();
+
+  if(path == "-") {
+    return _good = _stream(STDIN_FILENO);
+  }
+
+  int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+
+  if(fd == -1) {
+    return false;
+  }
+
+  struct stat st;
+
+  if(::fstat(fd, &st) == -1) {
+    ::close(fd);
+    return false;
+  }
+
+  // Pipes, fifos and devices are streamed into the local buffer.
+  if(not S_ISREG(st.st_mode)) {
+    _good = _stream(fd);
+    ::close(fd);
+    return _good;
+  }
+
+  // An empty file cannot be mapped but is still a valid input.
+  if(st.st_size == 0) {
+    ::close(fd);
+    _data = _buffer.data();
+    return _good = true;
+  }
+
+  void* addr = ::mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+
+  if(addr == MAP_FAILED) {
+    _good = _stream(fd);
+    ::close(fd);
+    return _good;
+  }
+
+  ::madvise(addr, st.st_size, MADV_SEQUENTIAL);
+  ::close(fd);
+
+  _data   = static_cast<const char*>(addr);
+  _size   = st.st_size;
+  _mapped = true;
+
+  return _good = true;
+}
+
+// Procedure: close
+inline void MappedFile::close() {
+  if(_mapped) {
+    ::munmap(const_cast<char*>(_data), _size);
+  }
+  _buffer.clear();
+  _buffer.shrink_to_fit();
+  _data   = nullptr;
+  _size   = 0;
+  _good   = false;
+  _mapped = false;
+}
+
+// Function: _stream
+// Read the descriptor to its end in fixed-size chunks.
+inline bool MappedFile::_stream(int fd) {
+
+  constexpr size_t chunk {1 << 16};
+
+  for(size_t n = 0;;) {
+    _buffer.resize(n + chunk);
+    auto ret = ::read(fd, _buffer.data() + n, chunk);
+    if(ret < 0) {
+      if(errno == EINTR) {
+        continue;
+      }
+      _buffer.clear();
+      return false;
+    }
+    if(ret == 0) {
+      _buffer.resize(n);
+      break;
+    }
+    n += ret;
+  }
+
+  _data = _buffer.data();
+  _size = _buffer.size();
+
+  return true;
+}
+
+
+};  // end of namespace sda. ----------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,146 @@
+#ifndef SDA_UTILITY_NAMES_HPP_
+#define SDA_UTILITY_NAMES_HPP_
+
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+#include <vector>
+#include <sda/utility/hash.hpp>
+
+namespace sda {
+
+// Class: NameTable
+// Compact table of interned names for large, local name spaces such as the
+// nets of a netlist, where the process-wide SymbolTable would cost too much
+// per name. Ids are dense and handed out in order of insertion. The names
+// live back to back in one character pool and are found through an
+// open-addressing hash table of ids, so a name costs its characters plus
+// about 16 bytes. Not thread-safe.
+class NameTable {
+
+  public:
+
+    static constexpr uint32_t NONE {std::numeric_limits<uint32_t>::max()};
+
+    uint32_t insert(std::string_view);
+    uint32_t find(std::string_view) const;
+
+    std::string_view operator [] (uint32_t) const;
+
+    size_t size() const;
+    bool empty() const;
+
+    size_t memory() const;
+
+    void reserve(size_t);
+    void clear();
+
+  private:
+
+    std::string _pool;
+    std::vector<uint64_t> _offsets {0};
+
+    // id + 1 of the name in each slot; 0 is an empty slot
+    std::vector<uint32_t> _slots;
+
+    size_t _probe(std::string_view) const;
+
+    void _rehash(size_t);
+};
+
+// Function: size
+inline size_t NameTable::size() const {
+  return _offsets.size() - 1;
+}
+
+// Function: empty
+inline bool NameTable::empty() const {
+  return size() == 0;
+}
+
+// Function: operator []
+inline std::string_view NameTable::operator [] (uint32_t id) const {
+  return {_pool.data() + _offsets[id], static_cast<size_t>(_offsets[id+1] - _offsets[id])};
+}
+
+// Function: memory
+// Return the bytes held by the table.
+inline size_t NameTable::memory() const {
+  return _pool.capacity() +
+         _offsets.capacity() * sizeof(uint64_t) +
+         _slots.capacity() * sizeof(uint32_t);
+}
+
+// Procedure: reserve
+inline void NameTable::reserve(size_t n) {
+  _offsets.reserve(n + 1);
+  if(2 * n > _slots.size()) {
+    _rehash(2 * n);
+  }
+}
+
+// Procedure: clear
+inline void NameTable::clear() {
+  _pool.clear();
+  _offsets.assign(1, 0);
+  _slots.clear();
+}
+
+// Function: _probe
+// Return the slot holding the name, or the empty slot where it would go.
+inline size_t NameTable::_probe(std::string_view s) const {
+  const size_t mask = _slots.size() - 1;
+  for(size_t i = hash64(s) & mask; ; i = (i + 1) & mask) {
+    if(_slots[i] == 0 || (*this)[_slots[i] - 1] == s) {
+      return i;
+    }
+  }
+}
+
+// Procedure: _rehash
+// Grow the slots to the next power of two of at least n.
+inline void NameTable::_rehash(size_t n) {
+  size_t num_slots = 16;
+  while(num_slots < n) {
+    num_slots <<= 1;
+  }
+  _slots.assign(num_slots, 0);
+  for(uint32_t id=0; id<size(); ++id) {
+    _slots[_probe((*this)[id])] = id + 1;
+  }
+}
+
+// Function: insert
+// Return the id of a name, inserting the name if it is new.
+inline uint32_t NameTable::insert(std::string_view s) {
+
+  // Keep the load factor at or below 1/2
+  if(2 * (size() + 1) > _slots.size()) {
+    _rehash(2 * _slots.size());
+  }
+
+  const auto slot = _probe(s);
+
+  if(_slots[slot] == 0) {
+    _pool.append(s);
+    _offsets.push_back(_pool.size());
+    _slots[slot] = static_cast<uint32_t>(size());
+  }
+
+  return _slots[slot] - 1;
+}
+
+// Function: find
+// Return the id of a name, or NONE if the name is not in the table.
+inline uint32_t NameTable::find(std::string_view s) const {
+  if(_slots.empty()) {
+    return NONE;
+  }
+  return _slots[_probe(s)] - 1;
+}
+
+
+};  // end of namespace sda. ----------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,183 @@
+#ifndef SDA_UTILITY_PATH_HPP_
+#define SDA_UTILITY_PATH_HPP_
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <sda/utility/symbol.hpp>
+
+namespace sda {
+
+// Type: Path
+// Dense 32-bit id of a hierarchical name such as a/b/c. The id 0 is the root,
+// i.e., the empty path.
+using Path = std::uint32_t;
+
+inline constexpr Path ROOT_PATH {0};
+
+// Class: PathTable
+// Process-wide trie of hierarchical names. A path is stored as its parent
+// path plus a leaf symbol, so the common prefixes of a deep hierarchy are
+// stored once. Each distinct path is handed out once. Strings are only built
+// by render, in O(depth). All operations are thread-safe.
+class PathTable : public EnableSingletonFromThis<PathTable> {
+
+  friend class EnableSingletonFromThis<PathTable>;
+
+  struct Node {
+    Path parent {ROOT_PATH};
+    Symbol leaf {EMPTY_SYMBOL};
+    uint32_t depth {0};
+  };
+
+  public:
+
+    Path child(Path, Symbol);
+    Path append(Path, Path);
+
+    Path parent(Path) const;
+    Symbol leaf(Path) const;
+    size_t depth(Path) const;
+
+    std::string render(Path, char = '/') const;
+
+    size_t size() const;
+
+  private:
+
+    PathTable();
+
+    mutable std::shared_mutex _mutex;
+
+    std::deque<Node> _nodes;
+    std::unordered_map<uint64_t, Path> _paths;
+
+    static uint64_t _key(Path, Symbol);
+};
+
+// Constructor
+inline PathTable::PathTable() {
+  _nodes.emplace_back();
+}
+
+// Function: _key
+inline uint64_t PathTable::_key(Path p, Symbol s) {
+  return (static_cast<uint64_t>(p) << 32) | s;
+}
+
+// Function: child
+// Return the path p/s, inserting it if it is new.
+inline Path PathTable::child(Path p, Symbol s) {
+
+  const auto key = _key(p, s);
+
+  {
+    std::shared_lock lock(_mutex);
+    if(auto itr = _paths.find(key); itr != _paths.end()) {
+      return itr->second;
+    }
+  }
+
+  std::scoped_lock lock(_mutex);
+
+  if(auto itr = _paths.find(key); itr != _paths.end()) {
+    return itr->second;
+  }
+
+  const auto id = static_cast<Path>(_nodes.size());
+  _nodes.push_back({p, s, _nodes[p].depth + 1});
+  _paths.emplace(key, id);
+  return id;
+}
+
+// Function: append
+// Return the path r re-rooted under p, in O(depth(r)).
+inline Path PathTable::append(Path p, Path r) {
+
+  std::vector<Symbol> leaves;
+
+  {
+    std::shared_lock lock(_mutex);
+    for(; r != ROOT_PATH; r = _nodes[r].parent) {
+      leaves.push_back(_nodes[r].leaf);
+    }
+  }
+
+  for(auto itr = leaves.rbegin(); itr != leaves.rend(); ++itr) {
+    p = child(p, *itr);
+  }
+
+  return p;
+}
+
+// Function: parent
+inline Path PathTable::parent(Path p) const {
+  std::shared_lock lock(_mutex);
+  return _nodes[p].parent;
+}
+
+// Function: leaf
+inline Symbol PathTable::leaf(Path p) const {
+  std::shared_lock lock(_mutex);
+  return _nodes[p].leaf;
+}
+
+// Function: depth
+inline size_t PathTable::depth(Path p) const {
+  std::shared_lock lock(_mutex);
+  return _nodes[p].depth;
+}
+
+// Function: render
+// Build the string of a path with the given divider between levels.
+inline std::string PathTable::render(Path p, char divider) const {
+
+  std::vector<Symbol> leaves;
+
+  {
+    std::shared_lock lock(_mutex);
+    leaves.reserve(_nodes[p].depth);
+    for(; p != ROOT_PATH; p = _nodes[p].parent) {
+      leaves.push_back(_nodes[p].leaf);
+    }
+  }
+
+  std::string str;
+
+  for(auto itr = leaves.rbegin(); itr != leaves.rend(); ++itr) {
+    if(itr != leaves.rbegin()) {
+      str.append(1, divider);
+    }
+    str.append(name_of(*itr));
+  }
+
+  return str;
+}
+
+// Function: size
+inline size_t PathTable::size() const {
+  std::shared_lock lock(_mutex);
+  return _nodes.size();
+}
+
+// ------------------------------------------------------------------------------------------------
+
+// Function: path_of
+// Return the single-level path of a name.
+inline Path path_of(Symbol s) {
+  return PathTable::get().child(ROOT_PATH, s);
+}
+
+// Function: render
+inline std::string render(Path p, char divider = '/') {
+  return PathTable::get().render(p, divider);
+}
+
+
+};  // end of namespace sda. ----------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,113 @@
+#ifndef SDA_UTILITY_SYMBOL_HPP_
+#define SDA_UTILITY_SYMBOL_HPP_
+
+#include <cstdint>
+#include <deque>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <sda/utility/index.hpp>
+#include <sda/utility/singleton.hpp>
+
+namespace sda {
+
+// Type: Symbol
+// Dense 32-bit id of an interned name. The id 0 is always the empty name.
+using Symbol = std::uint32_t;
+
+inline constexpr Symbol EMPTY_SYMBOL {0};
+
+// Class: SymbolTable
+// Process-wide table of interned names. Each distinct name is stored once and
+// handed out as a Symbol, so containers key on integers instead of strings.
+// Names are never released and views returned by the table stay valid for
+// the lifetime of the program. All operations are thread-safe.
+class SymbolTable : public EnableSingletonFromThis<SymbolTable> {
+
+  friend class EnableSingletonFromThis<SymbolTable>;
+
+  public:
+
+    Symbol intern(std::string_view);
+
+    bool contains(std::string_view) const;
+
+    std::string_view name(Symbol) const;
+
+    size_t size() const;
+
+  private:
+
+    SymbolTable();
+
+    mutable std::shared_mutex _mutex;
+
+    IndexGenerator<Symbol> _indices {0u};
+
+    std::deque<std::string> _names;
+    std::unordered_map<std::string_view, Symbol> _symbols;
+};
+
+// Constructor
+inline SymbolTable::SymbolTable() {
+  intern("");
+}
+
+// Function: intern
+// Return the symbol of a name, inserting the name if it is new.
+inline Symbol SymbolTable::intern(std::string_view s) {
+
+  {
+    std::shared_lock lock(_mutex);
+    if(auto itr = _symbols.find(s); itr != _symbols.end()) {
+      return itr->second;
+    }
+  }
+
+  std::scoped_lock lock(_mutex);
+
+  if(auto itr = _symbols.find(s); itr != _symbols.end()) {
+    return itr->second;
+  }
+
+  auto id = _indices.get();
+  _symbols.emplace(_names.emplace_back(s), id);
+  return id;
+}
+
+// Function: contains
+inline bool SymbolTable::contains(std::string_view s) const {
+  std::shared_lock lock(_mutex);
+  return _symbols.find(s) != _symbols.end();
+}
+
+// Function: name
+inline std::string_view SymbolTable::name(Symbol id) const {
+  std::shared_lock lock(_mutex);
+  return _names[id];
+}
+
+// Function: size
+inline size_t SymbolTable::size() const {
+  std::shared_lock lock(_mutex);
+  return _names.size();
+}
+
+// ------------------------------------------------------------------------------------------------
+
+// Function: intern
+inline Symbol intern(std::string_view s) {
+  return SymbolTable::get().intern(s);
+}
+
+// Function: name_of
+inline std::string_view name_of(Symbol id) {
+  return SymbolTable::get().name(id);
+}
+
+
+};  // end of namespace sda. ----------------------------------------------------------------------
+
+#endif
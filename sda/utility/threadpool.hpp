@@ -0,0 +1,257 @@
+#ifndef SDA_UTILITY_THREADPOOL_HPP_
+#define SDA_UTILITY_THREADPOOL_HPP_
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sda {
+
+// Class: Threadpool
+// Work-stealing thread pool. Every worker owns a task queue. A task spawned
+// from inside a worker goes to the back of that worker's queue and is popped
+// LIFO by its owner, which keeps dependent work hot in cache. Idle workers
+// steal FIFO from the front of the other queues. Tasks submitted from
+// outside the pool are spread round-robin.
+class Threadpool {
+
+  struct Worker {
+    std::mutex mutex;
+    std::deque<std::function<void()>> tasks;
+    std::thread thread;
+  };
+
+  public:
+
+    explicit Threadpool(unsigned = std::thread::hardware_concurrency());
+
+    ~Threadpool();
+
+    template <typename C>
+    void silent_async(C&&);
+
+    template <typename F>
+    void parallel_for(size_t, F&&);
+
+    void wait_for_all();
+
+    size_t num_workers() const;
+
+    bool is_owner() const;
+
+  private:
+
+    std::vector<std::unique_ptr<Worker>> _workers;
+
+    std::mutex _mutex;
+    std::condition_variable _work_cv;
+    std::condition_variable _done_cv;
+
+    std::atomic<size_t> _num_queued {0};
+    std::atomic<size_t> _num_unfinished {0};
+    std::atomic<size_t> _next {0};
+
+    bool _stop {false};
+
+    static thread_local Threadpool* _owner;
+    static thread_local size_t _id;
+
+    void _spawn(std::function<void()>&&);
+    void _worker_loop(size_t);
+
+    bool _pop(size_t, std::function<void()>&);
+};
+
+inline thread_local Threadpool* Threadpool::_owner {nullptr};
+inline thread_local size_t Threadpool::_id {0};
+
+// Constructor
+inline Threadpool::Threadpool(unsigned N) {
+
+  N = std::max(N, 1u);
+
+  _workers.reserve(N);
+  for(unsigned i=0; i<N; ++i) {
+    _workers.push_back(std::make_unique<Worker>());
+  }
+
+  for(unsigned i=0; i<N; ++i) {
+    _workers[i]->thread = std::thread([this, i] () { _worker_loop(i); });
+  }
+}
+
+// Destructor
+// Finish every queued task and join the workers.
+inline Threadpool::~Threadpool() {
+
+  wait_for_all();
+
+  {
+    std::scoped_lock lock(_mutex);
+    _stop = true;
+  }
+  _work_cv.notify_all();
+
+  for(auto& w : _workers) {
+    w->thread.join();
+  }
+}
+
+// Function: num_workers
+inline size_t Threadpool::num_workers() const {
+  return _workers.size();
+}
+
+// Function: is_owner
+// Return true if the caller is a worker of this pool.
+inline bool Threadpool::is_owner() const {
+  return _owner == this;
+}
+
+// Procedure: silent_async
+// Submit a task without a future. Tasks may spawn further tasks.
+template <typename C>
+void Threadpool::silent_async(C&& c) {
+  _spawn(std::function<void()>(std::forward<C>(c)));
+}
+
+// Procedure: parallel_for
+// Call f(i) for every i in [0, n) and return once all calls are done. The
+// indices are handed out one by one from a shared counter to one task per
+// worker and to the calling thread, which takes part, so a pool of N workers
+// runs N+1 calls at once. Must not be called from a worker of this pool.
+template <typename F>
+void Threadpool::parallel_for(size_t n, F&& f) {
+
+  std::atomic<size_t> next {0};
+
+  auto loop = [&next, &f, n] () {
+    for(size_t i; (i = next++) < n; ) {
+      f(i);
+    }
+  };
+
+  for(size_t w=0; w<std::min(n, _workers.size()); ++w) {
+    silent_async(loop);
+  }
+  loop();
+
+  wait_for_all();
+}
+
+// Procedure: wait_for_all
+// Block until every submitted task, including the ones they spawned, has
+// finished. Must not be called from a worker of this pool.
+inline void Threadpool::wait_for_all() {
+  std::unique_lock lock(_mutex);
+  _done_cv.wait(lock, [this] () { return _num_unfinished == 0; });
+}
+
+// Procedure: _spawn
+inline void Threadpool::_spawn(std::function<void()>&& task) {
+
+  ++_num_unfinished;
+
+  auto& w = is_owner() ? *_workers[_id] : *_workers[_next++ % _workers.size()];
+
+  // Count the task before it can be popped, so the count never drops below
+  // zero, and under the pool mutex so a worker going to sleep cannot miss it
+  {
+    std::scoped_lock lock(_mutex);
+    ++_num_queued;
+  }
+
+  {
+    std::scoped_lock lock(w.mutex);
+    w.tasks.push_back(std::move(task));
+  }
+  _work_cv.notify_one();
+}
+
+// Function: _pop
+// Take a task from the back of the own queue, or steal one from the front
+// of another queue.
+inline bool Threadpool::_pop(size_t id, std::function<void()>& task) {
+
+  {
+    auto& w = *_workers[id];
+    std::scoped_lock lock(w.mutex);
+    if(!w.tasks.empty()) {
+      task = std::move(w.tasks.back());
+      w.tasks.pop_back();
+      return true;
+    }
+  }
+
+  for(size_t i=1; i<_workers.size(); ++i) {
+    auto& w = *_workers[(id + i) % _workers.size()];
+    std::scoped_lock lock(w.mutex);
+    if(!w.tasks.empty()) {
+      task = std::move(w.tasks.front());
+      w.tasks.pop_front();
+      return true;
+    }
+  }
+
+  return false;
+}
+
+// Procedure: _worker_loop
+inline void Threadpool::_worker_loop(size_t id) {
+
+  _owner = this;
+  _id = id;
+
+  std::function<void()> task;
+
+  while(true) {
+
+    if(_pop(id, task)) {
+      --_num_queued;
+      task();
+      task = nullptr;
+      if(--_num_unfinished == 0) {
+        std::scoped_lock lock(_mutex);
+        _done_cv.notify_all();
+      }
+      continue;
+    }
+
+    std::unique_lock lock(_mutex);
+    _work_cv.wait(lock, [this] () { return _stop || _num_queued > 0; });
+    if(_stop && _num_queued == 0) {
+      break;
+    }
+  }
+}
+
+// Procedure: parallel_for
+// Call f(i) for every i in [0, n) on up to num_threads threads, the calling
+// thread included, with a pool made for the call. A single thread, or a
+// single index, runs inline. Use Threadpool::parallel_for to keep the
+// threads across calls.
+template <typename F>
+void parallel_for(size_t n, unsigned num_threads, F&& f) {
+
+  num_threads = std::clamp<size_t>(num_threads, 1, std::max<size_t>(n, 1));
+
+  if(num_threads == 1) {
+    for(size_t i=0; i<n; ++i) {
+      f(i);
+    }
+    return;
+  }
+
+  Threadpool(num_threads - 1).parallel_for(n, std::forward<F>(f));
+}
+
+
+};  // end of namespace sda. ----------------------------------------------------------------------
+
+#endif
@@ -1,5 +1,9 @@
 #include <sda/utility/tokenizer.hpp>
 
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#endif
+
 // TODO
 // 1. Consider removing the utf-8 bom (https://github.com/zer4tul/utf8-bom-strip)
 
@@ -21,143 +25,517 @@ std::string to_upper(std::string s) {
   return s;
 }
 
-// Function: is_numeric
-bool is_numeric(const std::string& token) {
-  return std::regex_match(token, std::regex("(\\+|-)?[0-9]*(\\.?([0-9]+))$")); 
+// ------------------------------------------------------------------------------------------------
+
+// Constructor
+Tokenizer::Tokenizer(std::string_view dels, std::string_view exps, bool comments, bool escapes) : 
+  _comments {comments},
+  _escapes  {escapes} {
+
+  for(auto c : {' ', '\t', '\n', '\r', '\v', '\f'}) {
+    _classes[static_cast<uint8_t>(c)] = SEPARATOR;
+  }
+
+  for(auto c : dels) {
+    _classes[static_cast<uint8_t>(c)] = SEPARATOR;
+    if(exps.find(c) != std::string_view::npos) {
+      _classes[static_cast<uint8_t>(c)] |= EXCEPTION;
+    }
+  }
+
+  for(size_t c=0; c<256; ++c) {
+    if(_classes[c] & SEPARATOR) {
+      _separators.push_back(static_cast<char>(c));
+      _ascii &= (c < 0x80);
+      _sep_lo[c & 0xf] |= static_cast<uint8_t>(1 << ((c >> 4) & 7));
+    }
+    if(_classes[c] & EXCEPTION) {
+      _exceptions.push_back(static_cast<char>(c));
+      _exp_lo[c & 0xf] |= static_cast<uint8_t>(1 << ((c >> 4) & 7));
+    }
+  }
+
+  if(_comments) {
+    _classes['/'] |= COMMENT;
+    _classes['#'] |= COMMENT;
+  }
+
+  if(_escapes) {
+    _classes['\\'] |= ESCAPE;
+  }
 }
 
-// Function: is_array
-bool is_array(const std::string& token) {
-  return std::regex_match(token, std::regex("[a-zA-Z_][a-zA-Z_0-9]*(\\[[0-9]+\\])+"));
+// Function: classify
+uint8_t Tokenizer::classify(char c) const {
+  return _classes[static_cast<uint8_t>(c)];
 }
 
-// Function: is_word
-bool is_word(const std::string& token) {
-  return std::regex_match(token, std::regex("[a-zA-Z_][a-zA-Z_0-9]*"));
+// Function: operator ()
+std::vector<std::string_view> Tokenizer::operator () (std::string_view str) const {
+  std::vector<std::string_view> tokens;
+  tokenize(str, tokens);
+  return tokens;
 }
 
-// ------------------------------------------------------------------------------------------------
+// Procedure: tokenize
+// Append the tokens of a buffer, picking the widest kernel the CPU supports.
+void Tokenizer::tokenize(std::string_view str, std::vector<std::string_view>& tokens) const {
+  _tokenize(str, tokens, false);
+}
 
-// Function: tokenize
-std::vector<std::string> tokenize(const std::string& str, std::string_view dels, std::string_view exps) {
+// Function: tokenize_partial
+// Tokenize the longest prefix of a buffer that further input cannot change
+// and return its size. A trailing token, or a comment start whose end is not
+// in the buffer yet, is left out, so a stream can carry it over to the next
+// chunk.
+size_t Tokenizer::tokenize_partial(std::string_view str, std::vector<std::string_view>& tokens) const {
+  return _tokenize(str, tokens, true);
+}
 
-  // Parse the token.
-  std::string token;
-  std::vector<std::string> tokens;
+// Function: _tokenize
+size_t Tokenizer::_tokenize(std::string_view str, std::vector<std::string_view>& tokens, bool partial) const {
+#if defined(__x86_64__) || defined(__i386__)
+  static const bool has_avx2 = __builtin_cpu_supports("avx2");
+  if(has_avx2 && _ascii) {
+    return _avx2(str, tokens, partial);
+  }
+  if(_separators.size() <= 32) {
+    return _sse2(str, tokens, partial);
+  }
+#endif
+  return _scalar(str, tokens, partial);
+}
 
-  for(size_t i=0; i<str.size(); ++i) {
-    bool is_del = (dels.find(str[i]) != std::string_view::npos);
-    if(is_del || str[i] == ' ' || str[i] == '\n' || str[i] == '\r') {
-      if(!token.empty()) {                            // Add the current token.
-        tokens.push_back(std::move(token));
-        token.clear();
-      }
-      if(is_del && exps.find(str[i]) != std::string_view::npos) {
-        token.push_back(str[i]);
-        tokens.push_back(std::move(token));
-      }
-    } else {
-      token.push_back(str[i]);  // Add the char to the current token.
-    }
+namespace {
+
+// Function: skip_comment
+// Return the position past the comment starting at str[i], or i if none
+// does. A line comment ends before its newline and an unterminated block
+// comment runs to the end of the buffer. On a partial buffer, return npos if
+// the end of the comment, or whether there is one, is not known yet.
+inline size_t skip_comment(std::string_view str, size_t i, bool partial) {
+
+  constexpr auto npos = std::string_view::npos;
+
+  if(str[i] == '/' && i + 1 == str.size()) {
+    return partial ? npos : i;
   }
 
-  if(!token.empty()) {
-    tokens.push_back(std::move(token));
+  if(str[i] == '/' && str[i+1] == '*') {
+    const auto e = str.find("*/", i + 2);
+    return e != npos ? e + 2 : (partial ? npos : str.size());
   }
 
-  return tokens;
+  if(str[i] == '#' || (str[i] == '/' && str[i+1] == '/')) {
+    const auto e = str.find_first_of("\n\r", i + 1);
+    return e != npos ? e : (partial ? npos : str.size());
+  }
+
+  return i;
 }
 
-//-------------------------------------------------------------------------------------------------
+// Function: skip_escaped
+// Return the position of the whitespace that ends the escaped identifier
+// starting at str[i]. On a partial buffer, return npos if it is not known yet.
+inline size_t skip_escaped(std::string_view str, size_t i, bool partial) {
+  const auto e = str.find_first_of(" \t\n\r\v\f", i + 1);
+  return e != std::string_view::npos ? e : (partial ? std::string_view::npos : str.size());
+}
 
-// Function: tokenize:
-std::vector<std::string> tokenize(
-  const std::filesystem::path& path, 
-  std::string_view dels,
-  std::string_view exps
+// Function: scan
+// Emit the tokens of a buffer given a block classifier returning the masks of
+// separators, exceptions and comment or escape starts ('/', '#' or '\\') of 32
+// bytes. Token boundaries are found from the transitions of the separator
+// mask, so blocks inside a token or a run of whitespace cost a few
+// instructions. A comment closes the current token, an escaped identifier
+// is a token of its own, and the scan resumes right after either. A '\\'
+// inside a token is an ordinary character. The tail is
+// classified byte by byte. Return the number of bytes consumed, which is
+// less than the buffer size only on a partial buffer.
+template <typename C>
+__attribute__((always_inline)) inline size_t scan(
+  std::string_view str, 
+  const std::array<uint8_t, 256>& classes, 
+  std::vector<std::string_view>& tokens,
+  bool partial,
+  C&& classify
 ) {
-  
-  using namespace std::literals::string_literals;
 
-  std::ifstream ifs(path, std::ios::ate);
+  const char* p = str.data();
+  const size_t n = str.size();
 
-  if(!ifs.good()) {
-    //throw std::invalid_argument("failed to open the file '"s + path.c_str() + '\'');
-    return {};
-  }
-  
-  // Read the file to a local buffer.
-  size_t fsize = ifs.tellg();
-  ifs.seekg(0, std::ios::beg);
-  std::vector<char> buffer(fsize + 1);
-  ifs.read(buffer.data(), fsize);
-  buffer[fsize] = 0;
-  
-  // Mart out the comment
-  for(size_t i=0; i<fsize; ++i) {
+  size_t i = 0;
+  size_t beg = 0;
+  uint32_t prev = 1;      // the byte before the buffer acts as a separator
 
-    // Block comment
-    if(buffer[i] == '/' && buffer[i+1] == '*') {
-      buffer[i] = buffer[i+1] = ' ';
-      for(i=i+2; i<fsize; buffer[i++]=' ') {
-        if(buffer[i] == '*' && buffer[i+1] == '/') {
-          buffer[i] = buffer[i+1] = ' ';
-          i = i+1;
+  while(i + 32 <= n) {
+
+    uint32_t sep, exp, com;
+    classify(p + i, sep, exp, com);
+
+    const uint32_t shifted = (sep << 1) | prev;
+    const uint32_t starts = ~sep & shifted;
+    const uint32_t ends = sep & ~shifted;
+
+    size_t next = i + 32;
+    bool in_token = !prev;
+
+    for(uint32_t events = starts | ends | exp | com; events; events &= events - 1) {
+      const uint32_t k = __builtin_ctz(events);
+      const uint32_t bit = 1u << k;
+      if(ends & bit) {
+        tokens.emplace_back(p + beg, i + k - beg);
+        in_token = false;
+      }
+      if((com & bit) && (p[i + k] != '\\' || (starts & bit))) {
+        const bool escaped = (p[i + k] == '\\');
+        if(const auto e = escaped ? skip_escaped(str, i + k, partial) : skip_comment(str, i + k, partial);
+           e == std::string_view::npos) {
+          return in_token ? beg : i + k;
+        }
+        else if(e != i + k) {
+          if(in_token) {
+            tokens.emplace_back(p + beg, i + k - beg);
+            in_token = false;
+          }
+          if(escaped) {
+            tokens.emplace_back(p + i + k, e - i - k);
+          }
+          next = e;
           break;
         }
       }
+      if(exp & bit) {
+        tokens.emplace_back(p + i + k, 1);
+      }
+      if(starts & bit) {
+        beg = i + k;
+        in_token = true;
+      }
     }
-    
-    // Line comment
-    if(buffer[i] == '/' && buffer[i+1] == '/') {
-      buffer[i] = buffer[i+1] = ' ';
-      for(i=i+2; i<fsize; ++i) {
-        if(buffer[i] == '\n' || buffer[i] == '\r') {
-          break;
+
+    prev = !in_token;
+    i = next;
+  }
+
+  while(i < n) {
+    const auto c = classes[static_cast<uint8_t>(p[i])];
+    if(const bool escaped = (c & Tokenizer::ESCAPE); (c & Tokenizer::COMMENT) || (escaped && prev)) {
+      if(const auto e = escaped ? skip_escaped(str, i, partial) : skip_comment(str, i, partial);
+         e == std::string_view::npos) {
+        return prev ? i : beg;
+      }
+      else if(e != i) {
+        if(!prev) {
+          tokens.emplace_back(p + beg, i - beg);
+        }
+        if(escaped) {
+          tokens.emplace_back(p + i, e - i);
         }
-        else buffer[i] = ' ';
+        prev = 1;
+        i = e;
+        continue;
       }
     }
-    
-    // Line comment
-    if(buffer[i] == '#') {
-      buffer[i] = ' ';
-      for(i=i+1; i<fsize; ++i) {
-        if(buffer[i] == '\n' || buffer[i] == '\r') {
-          break;
-        }
-        else buffer[i] = ' ';
+    if(c & Tokenizer::SEPARATOR) {
+      if(!prev) {
+        tokens.emplace_back(p + beg, i - beg);
+      }
+      if(c & Tokenizer::EXCEPTION) {
+        tokens.emplace_back(p + i, 1);
       }
+      prev = 1;
     }
+    else if(prev) {
+      beg = i;
+      prev = 0;
+    }
+    ++i;
   }
 
-  //std::cout << std::string_view(buffer.data()) << std::endl;
+  if(!prev) {
+    if(partial) {
+      return beg;
+    }
+    tokens.emplace_back(p + beg, n - beg);
+  }
 
-  // Parse the token.
-  std::string token;
-  std::vector<std::string> tokens;
+  return n;
+}
 
-  for(size_t i=0; i<fsize; ++i) {
-    bool is_del = (dels.find(buffer[i]) != std::string_view::npos);
-    if(is_del || buffer[i] == ' ' || buffer[i] == '\n' || buffer[i] == '\r') {
-      if(!token.empty()) {                            // Add the current token.
-        tokens.push_back(std::move(token));
-        token.clear();
-      }
-      if(is_del && exps.find(buffer[i]) != std::string_view::npos) {
-        token.push_back(buffer[i]);
-        tokens.push_back(std::move(token));
-      }
-    } else {
-      token.push_back(buffer[i]);  // Add the char to the current token.
+};  // end of anonymous namespace. ----------------------------------------------------------------
+
+// Function: _scalar
+size_t Tokenizer::_scalar(std::string_view str, std::vector<std::string_view>& tokens, bool partial) const {
+  return scan(str, _classes, tokens, partial, [this] (const char* p, uint32_t& sep, uint32_t& exp, uint32_t& com) {
+    sep = exp = com = 0;
+    for(uint32_t k=0; k<32; ++k) {
+      const uint32_t c = _classes[static_cast<uint8_t>(p[k])];
+      sep |= (c & SEPARATOR) << k;
+      exp |= ((c & EXCEPTION) >> 1) << k;
+      com |= static_cast<uint32_t>((c & (COMMENT | ESCAPE)) != 0) << k;
+    }
+  });
+}
+
+#if defined(__x86_64__) || defined(__i386__)
+
+namespace {
+
+// Struct: Sse2Classifier
+// Compare two 16-byte lanes against each separator and exception character.
+struct Sse2Classifier {
+
+  const __m128i* seps;
+  const __m128i* exps;
+  size_t num_seps;
+  size_t num_exps;
+  bool comments;
+  bool escapes;
+
+  __attribute__((target("sse2")))
+  void operator () (const char* p, uint32_t& sep, uint32_t& exp, uint32_t& com) const {
+    const __m128i a = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p));
+    const __m128i b = _mm_loadu_si128(reinterpret_cast<const __m128i*>(p + 16));
+    __m128i sa = _mm_setzero_si128(), sb = _mm_setzero_si128();
+    __m128i ea = _mm_setzero_si128(), eb = _mm_setzero_si128();
+    for(size_t k=0; k<num_seps; ++k) {
+      sa = _mm_or_si128(sa, _mm_cmpeq_epi8(a, seps[k]));
+      sb = _mm_or_si128(sb, _mm_cmpeq_epi8(b, seps[k]));
+    }
+    for(size_t k=0; k<num_exps; ++k) {
+      ea = _mm_or_si128(ea, _mm_cmpeq_epi8(a, exps[k]));
+      eb = _mm_or_si128(eb, _mm_cmpeq_epi8(b, exps[k]));
+    }
+    sep = static_cast<uint32_t>(_mm_movemask_epi8(sa)) | 
+          static_cast<uint32_t>(_mm_movemask_epi8(sb)) << 16;
+    exp = static_cast<uint32_t>(_mm_movemask_epi8(ea)) | 
+          static_cast<uint32_t>(_mm_movemask_epi8(eb)) << 16;
+    com = 0;
+    if(comments) {
+      const __m128i slash = _mm_set1_epi8('/'), hash = _mm_set1_epi8('#');
+      const __m128i ca = _mm_or_si128(_mm_cmpeq_epi8(a, slash), _mm_cmpeq_epi8(a, hash));
+      const __m128i cb = _mm_or_si128(_mm_cmpeq_epi8(b, slash), _mm_cmpeq_epi8(b, hash));
+      com = static_cast<uint32_t>(_mm_movemask_epi8(ca)) | 
+            static_cast<uint32_t>(_mm_movemask_epi8(cb)) << 16;
+    }
+    if(escapes) {
+      const __m128i backslash = _mm_set1_epi8('\\');
+      com |= static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(a, backslash))) | 
+             static_cast<uint32_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(b, backslash))) << 16;
+    }
+  }
+};
+
+// Struct: Avx2Classifier
+// Classify 32 bytes with two nibble lookups: the low nibble selects a mask of
+// high nibbles (0-7) whose character is in the set, and the high nibble 
+// selects its bit. Bytes >= 0x80 never match, hence the ASCII requirement.
+struct Avx2Classifier {
+
+  const uint8_t* sep_lo;
+  const uint8_t* exp_lo;
+  bool comments;
+  bool escapes;
+
+  __attribute__((target("avx2")))
+  void operator () (const char* p, uint32_t& sep, uint32_t& exp, uint32_t& com) const {
+    const __m256i hi_bit = _mm256_setr_epi8(
+      1, 2, 4, 8, 16, 32, 64, -128, 0, 0, 0, 0, 0, 0, 0, 0,
+      1, 2, 4, 8, 16, 32, 64, -128, 0, 0, 0, 0, 0, 0, 0, 0
+    );
+    const __m256i nibble = _mm256_set1_epi8(0x0f);
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i s_lo = _mm256_broadcastsi128_si256(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(sep_lo))
+    );
+    const __m256i e_lo = _mm256_broadcastsi128_si256(
+      _mm_loadu_si128(reinterpret_cast<const __m128i*>(exp_lo))
+    );
+    const __m256i v = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(p));
+    const __m256i lo = _mm256_and_si256(v, nibble);
+    const __m256i hi = _mm256_and_si256(_mm256_srli_epi16(v, 4), nibble);
+    const __m256i bit = _mm256_shuffle_epi8(hi_bit, hi);
+    const __m256i s = _mm256_and_si256(_mm256_shuffle_epi8(s_lo, lo), bit);
+    const __m256i e = _mm256_and_si256(_mm256_shuffle_epi8(e_lo, lo), bit);
+    sep = ~static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(s, zero)));
+    exp = ~static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(e, zero)));
+    com = 0;
+    if(comments) {
+      const __m256i c = _mm256_or_si256(
+        _mm256_cmpeq_epi8(v, _mm256_set1_epi8('/')), _mm256_cmpeq_epi8(v, _mm256_set1_epi8('#'))
+      );
+      com = static_cast<uint32_t>(_mm256_movemask_epi8(c));
+    }
+    if(escapes) {
+      com |= static_cast<uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(v, _mm256_set1_epi8('\\'))));
     }
   }
+};
 
-  if(!token.empty()) {
-    tokens.push_back(std::move(token));
+};  // end of anonymous namespace. ----------------------------------------------------------------
+
+// Function: _sse2
+__attribute__((target("sse2")))
+size_t Tokenizer::_sse2(std::string_view str, std::vector<std::string_view>& tokens, bool partial) const {
+
+  __m128i seps[32], exps[32];
+
+  for(size_t k=0; k<_separators.size(); ++k) {
+    seps[k] = _mm_set1_epi8(_separators[k]);
+  }
+  for(size_t k=0; k<_exceptions.size(); ++k) {
+    exps[k] = _mm_set1_epi8(_exceptions[k]);
   }
 
-  return tokens;
+  return scan(str, _classes, tokens, partial, Sse2Classifier{seps, exps, _separators.size(), _exceptions.size(), _comments, _escapes});
+}
+
+// Function: _avx2
+__attribute__((target("avx2")))
+size_t Tokenizer::_avx2(std::string_view str, std::vector<std::string_view>& tokens, bool partial) const {
+  return scan(str, _classes, tokens, partial, Avx2Classifier{_sep_lo.data(), _exp_lo.data(), _comments, _escapes});
+}
+
+#endif
+
+// ------------------------------------------------------------------------------------------------
+
+// Function: tokenize
+std::vector<std::string_view> tokenize(std::string_view str, std::string_view dels, std::string_view exps) {
+  return Tokenizer(dels, exps)(str);
+}
+
+//-------------------------------------------------------------------------------------------------
+
+// Function: tokenize
+// Tokenize a file with comments skipped. The file is mapped read-only.
+FileTokens tokenize(
+  const std::filesystem::path& path, 
+  std::string_view dels,
+  std::string_view exps
+) {
+  return FileTokens(path, Tokenizer(dels, exps, true));
+}
+
+// Constructor
+FileTokens::FileTokens(const std::filesystem::path& path, const Tokenizer& tokenizer) {
+  if(_file.open(path)) {
+    tokenizer.tokenize(_file.view(), _tokens);
+  }
+}
+
+// ------------------------------------------------------------------------------------------------
+
+// Constructor
+TokenStream::TokenStream(
+  const std::filesystem::path& path, 
+  std::string_view dels, 
+  std::string_view exps, 
+  bool escapes,
+  size_t chunk_size
+) : 
+  _tokenizer  {dels, exps, true, escapes},
+  _chunk_size {std::max(chunk_size, size_t{1})} {
+
+  if(path == "-") {
+    _fd = STDIN_FILENO;
+  }
+  else if((_fd = ::open(path.c_str(), O_RDONLY)) != -1) {
+    _owner = true;
+  }
+
+  _good = (_fd != -1);
+  _eof = !_good;
+}
+
+// Destructor
+TokenStream::~TokenStream() {
+  if(_owner) {
+    ::close(_fd);
+  }
+}
+
+// Function: good
+// Return false if the input could not be opened or read.
+bool TokenStream::good() const {
+  return _good;
+}
+
+// Function: begin
+// The stream is single-pass; begin starts it the first time only.
+TokenStream::iterator TokenStream::begin() {
+  if(!_started) {
+    _started = true;
+    _cursor = 0;
+    return iterator(_fill() ? this : nullptr);
+  }
+  return iterator(_cursor < _tokens.size() ? this : nullptr);
+}
+
+// Function: end
+TokenStream::iterator TokenStream::end() {
+  return iterator();
+}
+
+// Function: _next
+bool TokenStream::_next() {
+  return ++_cursor < _tokens.size() || _fill();
+}
+
+// Function: _fill
+// Drop the consumed bytes, read chunks until the buffer yields a token or
+// the input ends, and tokenize all but the undecided tail.
+bool TokenStream::_fill() {
+
+  _tokens.clear();
+  _cursor = 0;
+
+  while(true) {
+
+    _buffer.erase(_buffer.begin(), _buffer.begin() + _consumed);
+    _consumed = 0;
+
+    if(_eof) {
+      return false;
+    }
+
+    const auto size = _buffer.size();
+    _buffer.resize(size + _chunk_size);
+
+    ssize_t n;
+    while((n = ::read(_fd, _buffer.data() + size, _chunk_size)) == -1 && errno == EINTR);
+
+    if(n <= 0) {
+      _good = (n == 0);
+      _eof = true;
+      n = 0;
+    }
+
+    _buffer.resize(size + n);
+
+    const std::string_view view(_buffer.data(), _buffer.size());
+
+    if(_eof) {
+      _tokenizer.tokenize(view, _tokens);
+      _consumed = view.size();
+    }
+    else {
+      _consumed = _tokenizer.tokenize_partial(view, _tokens);
+    }
+
+    if(!_tokens.empty()) {
+      return true;
+    }
+  }
+}
+
+// Operator: ++
+TokenStream::iterator& TokenStream::iterator::operator ++ () {
+  if(!_stream->_next()) {
+    _stream = nullptr;
+  }
+  return *this;
 }
 
 // ------------------------------------------------------------------------------------------------
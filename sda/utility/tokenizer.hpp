@@ -1,14 +1,17 @@
 #ifndef SDA_UTILITY_TOKENIZER_HPP_
 #define SDA_UTILITY_TOKENIZER_HPP_
 
+#include <array>
+#include <cstdint>
 #include <vector>
 #include <string>
 #include <string_view>
 #include <fstream>
 #include <iostream>
 #include <algorithm>
-#include <regex>
+#include <iterator>
 #include <experimental/filesystem>
+#include <sda/utility/mmap.hpp>
 
 namespace std {
   namespace filesystem = experimental::filesystem;
@@ -20,10 +23,131 @@ namespace sda {
 std::string to_lower(std::string);
 std::string to_upper(std::string);
 
-// check string syntax
-bool is_numeric(const std::string&);
-bool is_array(const std::string&);
-bool is_word(const std::string&);
+// ------------------------------------------------------------------------------------------------
+
+// Token classes. The matchers below are hand-coded equivalents of the regular
+// expressions in their comments (ASCII, locale-independent). They neither
+// allocate nor throw, and they are constexpr.
+
+namespace token_detail {
+
+constexpr bool is_digit(char c) {
+  return c >= '0' && c <= '9';
+}
+
+constexpr bool is_head(char c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+}
+
+constexpr bool is_tail(char c) {
+  return is_head(c) || is_digit(c);
+}
+
+// Function: skip_digits
+constexpr size_t skip_digits(std::string_view s, size_t i) {
+  while(i < s.size() && is_digit(s[i])) ++i;
+  return i;
+}
+
+// Function: skip_word
+// Return the end of the word at s[0], or 0 if there is none.
+constexpr size_t skip_word(std::string_view s) {
+  if(s.empty() || !is_head(s[0])) {
+    return 0;
+  }
+  size_t i = 1;
+  while(i < s.size() && is_tail(s[i])) ++i;
+  return i;
+}
+
+};  // end of namespace token_detail. --------------------------------------------------------------
+
+// Function: is_numeric
+// (\+|-)?[0-9]*(\.?([0-9]+))
+constexpr bool is_numeric(std::string_view s) {
+  using namespace token_detail;
+  size_t i = (!s.empty() && (s[0] == '+' || s[0] == '-')) ? 1 : 0;
+  const size_t d = skip_digits(s, i);
+  if(d < s.size() && s[d] == '.') {
+    return d + 1 < s.size() && skip_digits(s, d + 1) == s.size();
+  }
+  return d > i && d == s.size();
+}
+
+// Function: is_word
+// [a-zA-Z_][a-zA-Z_0-9]*
+constexpr bool is_word(std::string_view s) {
+  const auto e = token_detail::skip_word(s);
+  return e != 0 && e == s.size();
+}
+
+// Function: is_array
+// [a-zA-Z_][a-zA-Z_0-9]*(\[[0-9]+\])+
+constexpr bool is_array(std::string_view s) {
+  using namespace token_detail;
+  size_t i = skip_word(s);
+  if(i == 0 || i == s.size()) {
+    return false;
+  }
+  while(i < s.size()) {
+    if(s[i] != '[') {
+      return false;
+    }
+    const size_t d = skip_digits(s, i + 1);
+    if(d == i + 1 || d == s.size() || s[d] != ']') {
+      return false;
+    }
+    i = d + 1;
+  }
+  return true;
+}
+
+// Enum: TokenClass
+enum class TokenClass : uint8_t {
+  OTHER = 0,
+  NUMERIC,
+  WORD,
+  ARRAY
+};
+
+// Function: classify_token
+// The classes are disjoint, so the first character decides which matcher
+// runs.
+constexpr TokenClass classify_token(std::string_view s) {
+  if(s.empty()) {
+    return TokenClass::OTHER;
+  }
+  if(token_detail::is_head(s[0])) {
+    return is_word(s) ? TokenClass::WORD : is_array(s) ? TokenClass::ARRAY : TokenClass::OTHER;
+  }
+  return is_numeric(s) ? TokenClass::NUMERIC : TokenClass::OTHER;
+}
+
+// Function: classify_tokens
+// Write the class of each token of [b, e) to out, like std::transform, and
+// return the end of the output.
+template <typename I, typename O>
+O classify_tokens(I b, I e, O out) {
+  for(; b != e; ++b, ++out) {
+    *out = classify_token(*b);
+  }
+  return out;
+}
+
+// Function: count_tokens
+// Return the number of tokens of [b, e) in the given class.
+template <typename I>
+size_t count_tokens(I b, I e, TokenClass c) {
+  size_t n = 0;
+  for(; b != e; ++b) {
+    n += (classify_token(*b) == c);
+  }
+  return n;
+}
+
+static_assert(is_numeric("-1.5") && is_numeric(".5") && !is_numeric("1.") && !is_numeric("+"));
+static_assert(is_word("_a1") && !is_word("1a") && !is_word(""));
+static_assert(is_array("a[0][12]") && !is_array("a") && !is_array("a[]") && !is_array("a[1]b"));
 
 // ------------------------------------------------------------------------------------------------
 
@@ -91,43 +215,202 @@ auto find_bracket_pair(const I b, const I e) {
 }
 
 // Function: on_next_parentheses
+// Apply c to every token between the next "(" and its matching ")" and return
+// the iterator at the ")", or e if there is none. The range is walked once, so
+// input iterators such as TokenStream::iterator work as well.
 template <typename I, typename C>
-auto on_next_parentheses(const I b, const I e, C&& c) {
-
-  auto l = std::find(b, e, "(");
-  auto r = l;
-  //std::find(l, e, ")");
+auto on_next_parentheses(I b, const I e, C&& c) {
 
-  int stack = 0;
+  if(b = std::find(b, e, "("); b == e) {
+    return e;
+  }
 
-  while(r != e) {
-    if(*r == "(") {
+  for(int stack = 1; ++b != e; ) {
+    if(*b == "(") {
       ++stack;
     }
-    else if(*r == ")") {
-      --stack;
-    }
-    if(stack == 0) {
-      break;
+    else if(*b == ")" && --stack == 0) {
+      return b;
     }
-    ++r;
+    c(*b);
   }
   
-  if(l == e || r == e) return e;
+  return e;
+}
 
-  for(++l; l != r; ++l) {
-    c(*l);
-  }
 
-  return r;
-}
+// Class: Tokenizer
+// Split a buffer into tokens separated by whitespace (' ', '\t', '\n', '\r',
+// '\v', '\f') and delimiters. Delimiters that are also exceptions are kept as
+// one-character tokens. Optionally, /* */, // and # comments are skipped as
+// whitespace in the same pass, so a read-only (e.g., mapped) buffer can be
+// tokenized as is, and verilog escaped identifiers (a '\' that begins a
+// token, up to the next whitespace) are kept whole, delimiters included.
+// The delimiter set is compiled once into a 256-entry class table; on x86 the
+// buffer is classified 16 (SSE2) or 32 (AVX2) bytes at a time, dispatched at
+// run time, with a scalar fallback. Tokens are views into the buffer, which
+// must outlive them.
+class Tokenizer {
+
+  public:
+
+    enum : uint8_t {
+      SEPARATOR = 1,
+      EXCEPTION = 2,
+      COMMENT   = 4,
+      ESCAPE    = 8
+    };
 
+    Tokenizer(std::string_view="", std::string_view="", bool=false, bool=false);
+
+    std::vector<std::string_view> operator () (std::string_view) const;
+
+    void tokenize(std::string_view, std::vector<std::string_view>&) const;
+
+    size_t tokenize_partial(std::string_view, std::vector<std::string_view>&) const;
+
+    uint8_t classify(char) const;
+
+  private:
+
+    std::array<uint8_t, 256> _classes {};
+
+    bool _comments {false};
+    bool _escapes {false};
+
+    // Distinct separator and exception characters for the SSE2 kernel
+    std::string _separators;
+    std::string _exceptions;
+
+    // Nibble lookup tables for the AVX2 kernel; valid if _ascii is true
+    alignas(16) std::array<uint8_t, 16> _sep_lo {};
+    alignas(16) std::array<uint8_t, 16> _exp_lo {};
+    bool _ascii {true};
+
+    size_t _tokenize(std::string_view, std::vector<std::string_view>&, bool) const;
+    size_t _scalar(std::string_view, std::vector<std::string_view>&, bool) const;
+    size_t _sse2(std::string_view, std::vector<std::string_view>&, bool) const;
+    size_t _avx2(std::string_view, std::vector<std::string_view>&, bool) const;
+};
+
+// Class: FileTokens
+// Tokens of a file together with the read-only mapping they view. The object
+// is neither copied nor moved, so the views can never dangle.
+class FileTokens {
+
+  friend FileTokens tokenize(const std::filesystem::path&, std::string_view, std::string_view);
+
+  public:
+
+    using iterator = std::vector<std::string_view>::const_iterator;
+
+    FileTokens(const FileTokens&) = delete;
+    FileTokens& operator = (const FileTokens&) = delete;
+
+    iterator begin() const { return _tokens.begin(); }
+    iterator end() const { return _tokens.end(); }
+
+    size_t size() const { return _tokens.size(); }
+    bool empty() const { return _tokens.empty(); }
+
+    std::string_view operator [] (size_t i) const { return _tokens[i]; }
+
+  private:
+
+    FileTokens(const std::filesystem::path&, const Tokenizer&);
+
+    MappedFile _file;
+    std::vector<std::string_view> _tokens;
+};
+
+// Class: TokenStream
+// Pull-based input range over the tokens of a file, a pipe or the standard
+// input (path "-"), with comments skipped and, optionally, escaped
+// identifiers kept whole. The input is read in fixed-size
+// chunks and tokenized lazily, so a file of any size is parsed in constant
+// memory and parsing can begin before the file is complete. A token or a
+// comment straddling two chunks is carried over to the next one. The current
+// token stays valid until the stream is advanced.
+class TokenStream {
+
+  public:
+
+    class iterator {
+
+      friend class TokenStream;
+
+      public:
+
+        using iterator_category = std::input_iterator_tag;
+        using value_type = std::string_view;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const std::string_view*;
+        using reference = const std::string_view&;
+
+        iterator() = default;
+
+        reference operator * () const { return _stream->_tokens[_stream->_cursor]; }
+        pointer operator -> () const { return &**this; }
+
+        iterator& operator ++ ();
+        void operator ++ (int) { ++*this; }
+
+        bool operator == (const iterator& rhs) const { return _stream == rhs._stream; }
+        bool operator != (const iterator& rhs) const { return _stream != rhs._stream; }
+
+      private:
+
+        iterator(TokenStream* stream) : _stream {stream} {}
+
+        TokenStream* _stream {nullptr};
+    };
+
+    TokenStream(
+      const std::filesystem::path&, 
+      std::string_view="", 
+      std::string_view="", 
+      bool=false,
+      size_t = 1 << 16
+    );
+
+    ~TokenStream();
+
+    TokenStream(const TokenStream&) = delete;
+    TokenStream& operator = (const TokenStream&) = delete;
+
+    bool good() const;
+
+    iterator begin();
+    iterator end();
+
+  private:
+
+    Tokenizer _tokenizer;
+
+    int _fd {-1};
+    bool _owner {false};
+    bool _good {false};
+    bool _eof {false};
+    bool _started {false};
+
+    size_t _chunk_size;
+    size_t _consumed {0};
+    size_t _cursor {0};
+
+    std::vector<char> _buffer;
+    std::vector<std::string_view> _tokens;
+
+    bool _next();
+    bool _fill();
+};
+
+// ------------------------------------------------------------------------------------------------
 
 // Function: tokenize
-std::vector<std::string> tokenize(const std::filesystem::path&, std::string_view="", std::string_view="");
+FileTokens tokenize(const std::filesystem::path&, std::string_view="", std::string_view="");
 
-// Function: split
-std::vector<std::string> tokenize(const std::string&, std::string_view="", std::string_view="");
+// Function: tokenize
+std::vector<std::string_view> tokenize(std::string_view, std::string_view="", std::string_view="");
 
 
 };  // end of namespace sda. ----------------------------------------------------------------------
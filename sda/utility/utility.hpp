@@ -5,8 +5,15 @@
 #include <sda/utility/logger.hpp>
 #include <sda/utility/tokenizer.hpp>
 #include <sda/utility/index.hpp>
+#include <sda/utility/symbol.hpp>
+#include <sda/utility/hash.hpp>
+#include <sda/utility/path.hpp>
+#include <sda/utility/names.hpp>
+#include <sda/utility/threadpool.hpp>
 #include <sda/utility/iterator.hpp>
 #include <sda/utility/os.hpp>
+#include <sda/utility/mmap.hpp>
+#include <sda/utility/writer.hpp>
 #include <sda/utility/scope_guard.hpp>
 #include <sda/utility/CLI11.hpp>
 
@@ -0,0 +1,283 @@
+#ifndef SDA_UTILITY_WRITER_HPP_
+#define SDA_UTILITY_WRITER_HPP_
+
+#include <algorithm>
+#include <cerrno>
+#include <charconv>
+#include <climits>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <utility>
+#include <vector>
+#include <fcntl.h>
+#include <sys/uio.h>
+#include <unistd.h>
+#include <experimental/filesystem>
+
+namespace std {
+  namespace filesystem = experimental::filesystem;
+};
+
+namespace sda {
+
+// Class: WriteBuffer
+// Growable byte buffer for formatting text. Integers are converted with
+// std::to_chars, so formatting neither allocates per value nor consults a
+// locale. Clearing the buffer keeps its capacity for reuse.
+class WriteBuffer {
+
+  public:
+
+    WriteBuffer& operator << (std::string_view);
+    WriteBuffer& operator << (char);
+
+    template <typename T, std::enable_if_t<std::is_integral_v<T>, void>* = nullptr>
+    WriteBuffer& operator << (T);
+
+    const char* data() const;
+    size_t size() const;
+    bool empty() const;
+    std::string_view view() const;
+
+    void reserve(size_t);
+    void clear();
+
+  private:
+
+    std::string _data;
+};
+
+// Operator: <<
+inline WriteBuffer& WriteBuffer::operator << (std::string_view s) {
+  _data.append(s);
+  return *this;
+}
+
+// Operator: <<
+inline WriteBuffer& WriteBuffer::operator << (char c) {
+  _data.push_back(c);
+  return *this;
+}
+
+// Operator: <<
+template <typename T, std::enable_if_t<std::is_integral_v<T>, void>*>
+WriteBuffer& WriteBuffer::operator << (T v) {
+  char buf[24];
+  auto [end, ec] = std::to_chars(buf, buf + sizeof(buf), v);
+  _data.append(buf, end - buf);
+  return *this;
+}
+
+// Function: data
+inline const char* WriteBuffer::data() const {
+  return _data.data();
+}
+
+// Function: size
+inline size_t WriteBuffer::size() const {
+  return _data.size();
+}
+
+// Function: empty
+inline bool WriteBuffer::empty() const {
+  return _data.empty();
+}
+
+// Function: view
+inline std::string_view WriteBuffer::view() const {
+  return _data;
+}
+
+// Procedure: reserve
+inline void WriteBuffer::reserve(size_t n) {
+  _data.reserve(n);
+}
+
+// Procedure: clear
+inline void WriteBuffer::clear() {
+  _data.clear();
+}
+
+// ------------------------------------------------------------------------------------------------
+
+// Class: Writer
+// Buffered output to a file descriptor. Text is formatted into one large
+// WriteBuffer that is flushed with write(2) whenever it fills up. Buffers
+// formatted elsewhere, e.g., shards of a large output built by several
+// threads, are written in order with writev(2) and no further copy. Errors
+// are sticky: after a failed write the writer is no longer good and drops
+// all output.
+class Writer {
+
+  public:
+
+    Writer() = default;
+    Writer(const std::filesystem::path&, size_t = 1 << 20);
+    Writer(int, size_t = 1 << 20);
+    ~Writer();
+
+    Writer(const Writer&) = delete;
+    Writer& operator = (const Writer&) = delete;
+
+    bool open(const std::filesystem::path&, size_t = 1 << 20);
+    bool close();
+
+    bool good() const;
+
+    template <typename T>
+    Writer& operator << (T&&);
+
+    bool write(const std::vector<WriteBuffer>&);
+    bool flush();
+
+  private:
+
+    int _fd {-1};
+    bool _owner {false};
+    bool _good {false};
+    size_t _capacity {1 << 20};
+
+    WriteBuffer _buffer;
+
+    bool _write(struct iovec*, int);
+};
+
+// Constructor
+// Write to the file at the path, or to the standard output on path "-".
+inline Writer::Writer(const std::filesystem::path& path, size_t capacity) {
+  open(path, capacity);
+}
+
+// Constructor
+// Write to an open descriptor, which the writer does not close.
+inline Writer::Writer(int fd, size_t capacity) :
+  _fd {fd}, _good {fd != -1}, _capacity {capacity} {
+  _buffer.reserve(_capacity);
+}
+
+// Destructor
+inline Writer::~Writer() {
+  close();
+}
+
+// Function: good
+inline bool Writer::good() const {
+  return _good;
+}
+
+// Function: open
+inline bool Writer::open(const std::filesystem::path& path, size_t capacity) {
+
+  close();
+
+  _capacity = capacity;
+  _buffer.reserve(_capacity);
+
+  if(path == "-") {
+    _fd = STDOUT_FILENO;
+    return _good = true;
+  }
+
+  _fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+  _owner = (_fd != -1);
+
+  return _good = _owner;
+}
+
+// Function: close
+// Flush the pending output and close the descriptor if the writer opened it.
+// Returns false if any write failed.
+inline bool Writer::close() {
+  const bool ok = flush();
+  if(_owner && ::close(_fd) == -1) {
+    _good = false;
+  }
+  _fd    = -1;
+  _owner = false;
+  return ok && std::exchange(_good, false);
+}
+
+// Operator: <<
+template <typename T>
+Writer& Writer::operator << (T&& v) {
+  _buffer << std::forward<T>(v);
+  if(_buffer.size() >= _capacity) {
+    flush();
+  }
+  return *this;
+}
+
+// Function: flush
+inline bool Writer::flush() {
+  if(!_buffer.empty()) {
+    struct iovec iov {const_cast<char*>(_buffer.data()), _buffer.size()};
+    _write(&iov, 1);
+    _buffer.clear();
+  }
+  return _good;
+}
+
+// Function: write
+// Write the pending output followed by the given buffers, in order.
+inline bool Writer::write(const std::vector<WriteBuffer>& buffers) {
+
+  std::vector<struct iovec> iovs;
+  iovs.reserve(buffers.size() + 1);
+
+  if(!_buffer.empty()) {
+    iovs.push_back({const_cast<char*>(_buffer.data()), _buffer.size()});
+  }
+
+  for(const auto& b : buffers) {
+    if(!b.empty()) {
+      iovs.push_back({const_cast<char*>(b.data()), b.size()});
+    }
+  }
+
+  for(size_t i=0; i<iovs.size(); i+=IOV_MAX) {
+    _write(iovs.data() + i, static_cast<int>(std::min<size_t>(IOV_MAX, iovs.size() - i)));
+  }
+
+  _buffer.clear();
+
+  return _good;
+}
+
+// Function: _write
+// Write the vectors to the end, resuming after short writes and signals.
+inline bool Writer::_write(struct iovec* iov, int n) {
+
+  while(_good && n > 0) {
+
+    auto ret = ::writev(_fd, iov, n);
+
+    if(ret < 0) {
+      if(errno == EINTR) {
+        continue;
+      }
+      _good = false;
+      break;
+    }
+
+    // Skip the vectors written and advance into the partially written one.
+    size_t k = ret;
+    while(n > 0 && k >= iov->iov_len) {
+      k -= iov->iov_len;
+      ++iov;
+      --n;
+    }
+
+    if(n > 0) {
+      iov->iov_base = static_cast<char*>(iov->iov_base) + k;
+      iov->iov_len -= k;
+    }
+  }
+
+  return _good;
+}
+
+
+};  // end of namespace sda. ----------------------------------------------------------------------
+
+#endif
@@ -0,0 +1,163 @@
+// Unit test: des
+// The edges of a built graph follow the directions of the pins of the tech
+// cells and the ports of the child modules, not the order of the statements,
+// a wire without exactly one driver is rejected, and so is a pin bound to a
+// wire of the other kind or to a port against its direction.
+//
+// Usage: test_des <example/darpa-idea>
+
+#include <sda/headerdef.hpp>
+#include <sda/des/des.hpp>
+
+std::filesystem::path example;
+
+size_t num_failed {0};
+
+// Procedure: check
+void check(bool ok, const std::string& what) {
+  if(!ok) {
+    std::cerr << "FAILED: " << what << '\n';
+    ++num_failed;
+  }
+}
+
+// Function: edges
+// Build a flow against the example tech cells and return the edges of the
+// flattened top module as "from -> to", by wire, or nothing if it fails.
+std::optional<std::map<std::string, std::string>> edges(const std::string& flow, const std::string& top) {
+
+  sda::Des des;
+
+  if(!des.load_tech(example) || !des.parse_buffer(flow) || !des.build_graph()) {
+    return std::nullopt;
+  }
+
+  std::map<std::string, std::string> edges;
+  for(const auto& [name, e] : des.flatten(sda::intern(top)).edges) {
+    edges[sda::render(name)] = sda::render(e.from) + " -> " + sda::render(e.to);
+  }
+  return edges;
+}
+
+// Procedure: statement_order
+// Swap the two cells of the example flow.
+void statement_order() {
+
+  std::ifstream ifs(example / "flow.des");
+  const std::string flow {std::istreambuf_iterator<char>(ifs), std::istreambuf_iterator<char>()};
+
+  const auto pr {flow.find("PR ")};
+  const auto ot {flow.find("OT1 ")};
+
+  if(pr == std::string::npos || ot == std::string::npos || pr > ot) {
+    check(false, "flow.des has the cells PR and then OT1");
+    return;
+  }
+
+  const auto pr_line {flow.substr(pr, flow.find('\n', pr) + 1 - pr)};
+  const auto ot_line {flow.substr(ot, flow.find('\n', ot) + 1 - ot)};
+
+  auto swapped {flow};
+  swapped.replace(ot, ot_line.size(), pr_line);
+  swapped.replace(pr, pr_line.size(), ot_line);
+
+  const auto before {edges(flow, "Flow")};
+  const auto after {edges(swapped, "Flow")};
+
+  check(before && before->at("w") == "A -> b", "flow.des: w runs from A to b");
+  check(before && after && *before == *after, "flow.des: swapping the cells keeps the edges");
+}
+
+// Procedure: child_modules
+// A wire driven by the output port of a child module, stated after its sink.
+void child_modules() {
+
+  const std::string leaf {
+    "module Leaf(i, o);\n"
+    "input i;\n"
+    "output o;\n"
+    "wire x dependency;\n"
+    "PR p(.i(i), .o(x));\n"
+    "OT1 q(.i(x), .o(o));\n"
+    "endmodule\n"
+  };
+
+  const auto top = [&] (bool sink_first) {
+    const std::string sink {"OT1 c(.i(w), .o(out));\n"};
+    const std::string driver {"Leaf l(.i(in), .o(w));\n"};
+    return leaf +
+      "module Top(in, out);\n"
+      "input in;\n"
+      "output out;\n"
+      "wire w dependency;\n" +
+      (sink_first ? sink + driver : driver + sink) +
+      "endmodule\n";
+  };
+
+  const auto before {edges(top(false), "Top")};
+  const auto after {edges(top(true), "Top")};
+
+  check(before && before->at("w") == "l/q -> c", "child module: w runs from l/q to c");
+  check(before && after && *before == *after, "child module: swapping the instances keeps the edges");
+}
+
+// Procedure: drivers
+// Wires with two drivers, two sinks or a lone sink.
+void drivers() {
+
+  auto flow = [] (const std::string& cells) {
+    return "module Bad();\nwire w dependency;\n" + cells + "endmodule\n";
+  };
+
+  check(!edges(flow("PR a(.o(w));\nPR b(.o(w));\n"), "Bad"), "two drivers are rejected");
+  check(!edges(flow("OT1 a(.i(w));\nOT1 b(.i(w));\n"), "Bad"), "two sinks are rejected");
+  check(!edges(flow("OT1 a(.i(w));\n"), "Bad"), "a lone sink is rejected");
+  check(edges(flow("PR a(.o(w));\n"), "Bad").has_value(), "a lone driver is accepted");
+}
+
+// Procedure: wire_kinds
+// Pins on wires of the other kind, and ports bound against their direction.
+void wire_kinds() {
+
+  const std::string leaf {
+    "module Leaf(i, o);\n"
+    "input i;\n"
+    "output o;\n"
+    "PR p(.i(i), .o(o));\n"
+    "endmodule\n"
+  };
+
+  auto flow = [] (const std::string& body) {
+    return "module Bad(in, out);\ninput in;\noutput out;\n" + body + "endmodule\n";
+  };
+
+  check(!edges(flow("wire w stream;\nPR a(.i(in), .o(w));\nOT1 b(.i(w), .o(out));\n"), "Bad"),
+        "dependency pins on a stream wire are rejected");
+  check(!edges(flow("PR a(.i(in), .o(in));\nOT1 b(.i(in), .o(out));\n"), "Bad"),
+        "an output pin on an input port is rejected");
+  check(!edges(flow("PR a(.i(out), .o(out));\n"), "Bad"),
+        "an input pin on an output port is rejected");
+  check(!edges(leaf + flow("Leaf l(.i(out), .o(out));\n"), "Bad"),
+        "an output port bound to a child input is rejected");
+  check(!edges(leaf + flow("Leaf l(.i(in), .o(in));\n"), "Bad"),
+        "an input port bound to a child output is rejected");
+  check(edges(leaf + flow("Leaf l(.i(in), .o(out));\n"), "Bad").has_value(),
+        "ports bound along their directions are accepted");
+}
+
+int main(int argc, char* argv[]) {
+
+  if(argc < 2) {
+    std::cerr << "usage: test_des <example/darpa-idea>\n";
+    return EXIT_FAILURE;
+  }
+
+  example = argv[1];
+
+  statement_order();
+  child_modules();
+  drivers();
+  wire_kinds();
+
+  return num_failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}
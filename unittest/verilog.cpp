@@ -0,0 +1,121 @@
+// Unit test: verilog
+// The netlist reader takes any whitespace as a separator and escaped
+// identifiers as names, in one piece and in parallel chunks, writes escaped
+// names back so that they read the same, and rejects continuous assignments.
+//
+// Usage: test_verilog <scratch directory>
+
+#include <sda/des/module.hpp>
+#include <sda/utility/tokenizer.hpp>
+#include <sstream>
+
+std::filesystem::path scratch;
+
+size_t num_failed {0};
+
+// Procedure: check
+void check(bool ok, const std::string& what) {
+  if(!ok) {
+    std::cerr << "FAILED: " << what << '\n';
+    ++num_failed;
+  }
+}
+
+// Function: text
+std::string text(const sda::des::Netlist& n) {
+  std::ostringstream oss;
+  oss << n;
+  return oss.str();
+}
+
+// Function: read
+std::optional<sda::des::Netlist> read(const std::string& name, const std::string& verilog, unsigned threads = 1) {
+  const auto path = scratch / name;
+  std::ofstream(path) << verilog;
+  return sda::des::read_verilog(path, threads);
+}
+
+// Procedure: tokens
+// Every kernel of the tokenizer, and its byte-wise tail, at every offset.
+void tokens() {
+
+  const sda::Tokenizer tokenizer("(),;[]:.={}", "(),;[]:.={}", true, true);
+
+  const std::vector<std::string_view> expected {
+    "g1", "(", ".", "A", "(", "\\n1[0]", ")", ",", ".", "B", "(", "\\a/*b;", ")", ")", ";"
+  };
+
+  for(size_t pad=0; pad<=64; ++pad) {
+    const auto str = std::string(pad, ' ') + "\tg1\t(.A(\\n1[0] ),\v.B(\\a/*b; ))\f;\n";
+    check(tokenizer(str) == expected, "tokens after " + std::to_string(pad) + " spaces");
+  }
+
+  std::vector<std::string_view> partial;
+  const std::string_view cut {"wire \\n1[0]"};
+  check(tokenizer.tokenize_partial(cut, partial) == 5, "an escaped name cut at the end is held back");
+
+  check(sda::Tokenizer()("a\\b c") == std::vector<std::string_view>{"a\\b", "c"}, "no escapes by default");
+}
+
+// Procedure: netlist
+void netlist() {
+
+  const std::string verilog {
+    "module top (a, \\b[0] );\n"
+    "\tinput a;\n"
+    "\toutput \\b[0] ;\n"
+    "\twire \\n1[0] ;\n"
+    "\tINV g1 (.A(a), .Y(\\n1[0] ));\n"
+    "\tBUF \\g/2 (.A(\\n1[0] ), .Y(\\b[0] ));\n"
+    "endmodule\n"
+  };
+
+  const auto n = read("escaped.v", verilog);
+
+  check(n && n->num_gates() == 2 && n->nets.find("\\n1[0]") != sda::NameTable::NONE &&
+        n->gates.find("\\g/2") != sda::NameTable::NONE, "tabs and escaped names are read");
+
+  if(n) {
+    const auto path = scratch / "escaped_out.v";
+    const auto again = sda::des::write_verilog(path, *n, 1) ? sda::des::read_verilog(path, 1) : std::nullopt;
+    check(again && text(*again) == text(*n), "escaped names are written back as they read");
+  }
+
+  check(!read("assign.v", "module top (a, b);\ninput a;\noutput b;\nassign b = a;\nendmodule\n"),
+        "assign is rejected");
+}
+
+// Procedure: chunks
+// A netlist large enough to be read in chunks, with semicolons in escaped
+// names that the splitter takes for the ends of statements.
+void chunks() {
+
+  std::string verilog {"module big (a);\ninput a;\n"};
+
+  for(size_t g=0; verilog.size() < (10 << 20); ++g) {
+    const auto i = std::to_string(g);
+    verilog += "\tBUF\tg" + i + "\t(.A(\\n;" + i + " ),\t.Y(\\n;" + std::to_string(g + 1) + " ));\n";
+  }
+  verilog += "endmodule\n";
+
+  const auto one = read("big.v", verilog, 1);
+  const auto four = sda::des::read_verilog(scratch / "big.v", 4);
+
+  check(one && four && text(*one) == text(*four), "chunks read as one piece");
+}
+
+int main(int argc, char* argv[]) {
+
+  if(argc < 2) {
+    std::cerr << "usage: test_verilog <scratch directory>\n";
+    return EXIT_FAILURE;
+  }
+
+  scratch = argv[1];
+
+  tokens();
+  netlist();
+  chunks();
+
+  return num_failed == 0 ? EXIT_SUCCESS : EXIT_FAILURE;
+}